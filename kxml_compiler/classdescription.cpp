@@ -22,7 +22,11 @@
 #include "classdescription.h"
 
 ClassProperty::ClassProperty(const QString &type, const QString &name)
-    : m_type(type), m_name(name), m_isList(false), m_targetHasId(false)
+    : m_type(type),
+      m_name(name),
+      m_isList(false),
+      m_targetHasId(false),
+      m_targetHasUpdatedTimestamp(false)
 {
 }
 
@@ -56,6 +60,16 @@ bool ClassProperty::targetHasId() const
     return m_targetHasId;
 }
 
+void ClassProperty::setTargetHasUpdatedTimestamp(bool v)
+{
+    m_targetHasUpdatedTimestamp = v;
+}
+
+bool ClassProperty::targetHasUpdatedTimestamp() const
+{
+    return m_targetHasUpdatedTimestamp;
+}
+
 ClassDescription::ClassDescription(const QString &name) : m_name(name) {}
 
 QString ClassDescription::name() const
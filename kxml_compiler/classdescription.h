@@ -43,12 +43,16 @@ public:
     void setTargetHasId(bool);
     bool targetHasId() const;
 
+    void setTargetHasUpdatedTimestamp(bool);
+    bool targetHasUpdatedTimestamp() const;
+
 private:
     QString m_type;
     QString m_name;
 
     bool m_isList;
     bool m_targetHasId;
+    bool m_targetHasUpdatedTimestamp;
 };
 
 class ClassDescription
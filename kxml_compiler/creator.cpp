@@ -24,7 +24,9 @@
 #include "namer.h"
 
 #include "parsercreatordom.h"
+#include "parsercreatorstream.h"
 #include "writercreator.h"
+#include "jsoncreator.h"
 
 #include <code_generation/code.h>
 #include <code_generation/printer.h>
@@ -40,6 +42,7 @@
 #include <QMap>
 #include <QList>
 
+#include <algorithm>
 #include <iostream>
 
 Creator::ClassFlags::ClassFlags(const Schema::Element &element)
@@ -66,6 +69,11 @@ Creator::Creator(const Schema::Document &document, XmlParserType p)
 
 // FIXME: Handle creation options via flags enum.
 
+bool Creator::hasPendingTimestamps(const Schema::Element &element) const
+{
+    return mCreateCrudFunctions && element.hasRelation("updated_at");
+}
+
 void Creator::setVerbose(bool verbose)
 {
     mVerbose = verbose;
@@ -96,6 +104,139 @@ void Creator::setCreateParserFunctions(bool createParser)
     mCreateParserFunctions = createParser;
 }
 
+void Creator::setCreateVisitor(bool createVisitor)
+{
+    mCreateVisitor = createVisitor;
+}
+
+bool Creator::createVisitor() const
+{
+    return mCreateVisitor;
+}
+
+void Creator::setCreateArena(bool createArena)
+{
+    mCreateArena = createArena;
+}
+
+bool Creator::createArena() const
+{
+    return mCreateArena;
+}
+
+void Creator::setUseSharedData(bool useSharedData)
+{
+    mUseSharedData = useSharedData;
+}
+
+bool Creator::useSharedData() const
+{
+    return mUseSharedData;
+}
+
+void Creator::setParallelParse(bool parallelParse)
+{
+    mParallelParse = parallelParse;
+}
+
+bool Creator::parallelParse() const
+{
+    return mParallelParse;
+}
+
+void Creator::setParallelWrite(bool parallelWrite)
+{
+    mParallelWrite = parallelWrite;
+}
+
+bool Creator::parallelWrite() const
+{
+    return mParallelWrite;
+}
+
+void Creator::setLazyParse(bool lazyParse)
+{
+    mLazyParse = lazyParse;
+}
+
+bool Creator::lazyParse() const
+{
+    return mLazyParse && mCreateParserFunctions;
+}
+
+void Creator::setIncremental(bool incremental)
+{
+    mIncremental = incremental;
+}
+
+bool Creator::incremental() const
+{
+    return mIncremental && mCreateParserFunctions;
+}
+
+void Creator::setCreateBinaryFunctions(bool createBinaryFunctions)
+{
+    mCreateBinaryFunctions = createBinaryFunctions;
+}
+
+bool Creator::createBinaryFunctions() const
+{
+    return mCreateBinaryFunctions;
+}
+
+void Creator::setCreateJsonFunctions(bool createJsonFunctions)
+{
+    mCreateJsonFunctions = createJsonFunctions;
+}
+
+bool Creator::createJsonFunctions() const
+{
+    return mCreateJsonFunctions;
+}
+
+void Creator::setValidate(bool validate)
+{
+    mValidate = validate;
+}
+
+bool Creator::validate() const
+{
+    return mValidate;
+}
+
+QString Creator::materializer(const QString &name)
+{
+    return "materialize" + Namer::getClassName(name);
+}
+
+QString Creator::enumValue(const QString &enumName, const QString &value)
+{
+    return enumName + '_' + value;
+}
+
+QString Creator::memberAccess(const QString &member) const
+{
+    if (mUseSharedData) {
+        return "d->" + member;
+    } else {
+        return member;
+    }
+}
+
+QString Creator::constMemberAccess(const QString &member) const
+{
+    if (mUseSharedData) {
+        return "d.constData()->" + member;
+    } else {
+        return member;
+    }
+}
+
+QString Creator::visitorClassName() const
+{
+    return Namer::getClassName(mDocument.startElement().name()) + "Visitor";
+}
+
 void Creator::setLicense(const KODE::License &l)
 {
     mFile.setLicense(l);
@@ -124,43 +265,239 @@ KODE::File &Creator::file()
     return mFile;
 }
 
+// Types which are cheaper to return by value than by reference
+static bool isPrimitiveType(const QString &type)
+{
+    static const QStringList primitiveTypes = { "int",    "double",    "bool",
+                                                "qint32", "qlonglong", "quint64" };
+    return primitiveTypes.contains(type) || type.endsWith("Enum");
+}
+
 void Creator::createProperty(KODE::Class &c, const ClassDescription &description,
-                             const QString &type, const QString &name)
+                             const QString &type, const QString &name, bool lazy,
+                             const QString &indexMember, const QString &hashesMember)
 {
     if (type.startsWith("Q")) {
         c.addHeaderInclude(type);
     }
 
-    KODE::MemberVariable v(Namer::getClassName(name), type);
+    // A pending UpdatedAt timestamp is set by the const accessor
+    const bool isUpdatedAt = mCreateCrudFunctions && name == "UpdatedAt";
+    KODE::MemberVariable v(Namer::getClassName(name), isUpdatedAt ? "mutable " + type : type);
     c.addMemberVariable(v);
 
+    // A lazy property keeps the DOM elements it is parsed from until it is
+    // accessed. Setting it discards them. Each kept element keeps the whole
+    // QDomDocument alive.
+    const bool isList = type.endsWith("::List");
+    QString discardPending;
+    if (lazy) {
+        c.addHeaderInclude("QDomElement");
+
+        KODE::MemberVariable pending(Namer::getClassName(name) + (isList ? "Elements" : "Element"),
+                                     isList ? "QList<QDomElement>" : "QDomElement");
+        c.addMemberVariable(pending);
+
+        if (isList) {
+            discardPending = memberAccess(pending.name()) + ".clear();";
+        } else {
+            discardPending = memberAccess(pending.name()) + " = QDomElement();";
+        }
+
+        createMaterializer(c, type, name, pending.name());
+    }
+
+    // Changes mark the UpdatedAt timestamp as pending, setting it explicitly
+    // clears the pending flag
+    QString timestampUpdate;
+    if (isUpdatedAt) {
+        timestampUpdate = memberAccess("mUpdatedAtPending") + " = false;";
+    } else if (mCreateCrudFunctions && name != "CreatedAt"
+               && description.hasProperty("UpdatedAt")) {
+        timestampUpdate = memberAccess("mUpdatedAtPending") + " = true;";
+    }
+
+    // Replacing the list invalidates the positions in its id index and the
+    // source hashes of its items
+    QString discardIndex;
+    if (!indexMember.isEmpty()) {
+        discardIndex = memberAccess(indexMember + "Valid") + " = false;";
+    }
+    QString discardHashes;
+    if (!hashesMember.isEmpty()) {
+        discardHashes = memberAccess(hashesMember) + ".clear();";
+    }
+
     KODE::Function mutator(Namer::getMutator(name), "void");
     if (type == "int" || type == "double") {
         mutator.addArgument(type + " v");
     } else {
         mutator.addArgument("const " + type + " &v");
     }
-    mutator.addBodyLine(v.name() + " = v;");
-    if (mCreateCrudFunctions) {
-        if (name != "UpdatedAt" && name != "CreatedAt") {
-            if (description.hasProperty("UpdatedAt")) {
-                mutator.addBodyLine("setUpdatedAt( QDateTime::currentDateTime() );");
-            }
-        }
+    if (lazy) {
+        mutator.addBodyLine(discardPending);
+    }
+    if (!discardIndex.isEmpty()) {
+        mutator.addBodyLine(discardIndex);
+    }
+    if (!discardHashes.isEmpty()) {
+        mutator.addBodyLine(discardHashes);
+    }
+    mutator.addBodyLine(memberAccess(v.name()) + " = v;");
+    if (!timestampUpdate.isEmpty()) {
+        mutator.addBodyLine(timestampUpdate);
     }
     c.addFunction(mutator);
 
+    if (!isPrimitiveType(type)) {
+        c.addInclude("utility");
+
+        KODE::Function moveMutator(Namer::getMutator(name), "void");
+        moveMutator.addArgument(type + " &&v");
+        if (lazy) {
+            moveMutator.addBodyLine(discardPending);
+        }
+        if (!discardIndex.isEmpty()) {
+            moveMutator.addBodyLine(discardIndex);
+        }
+        if (!discardHashes.isEmpty()) {
+            moveMutator.addBodyLine(discardHashes);
+        }
+        moveMutator.addBodyLine(memberAccess(v.name()) + " = std::move( v );");
+        if (!timestampUpdate.isEmpty()) {
+            moveMutator.addBodyLine(timestampUpdate);
+        }
+        c.addFunction(moveMutator);
+    }
+
     KODE::Function accessor(Namer::getAccessor(name), type);
     accessor.setConst(true);
     if (type.right(4) == "Enum") {
         accessor.setReturnType(c.name() + "::" + type);
+    } else if (!isPrimitiveType(type)) {
+        accessor.setReturnType("const " + type + " &");
     }
 
-    accessor.addBodyLine("return " + v.name() + ';');
+    KODE::Code code;
+    if (lazy) {
+        accessor.setDocs("Return the " + Namer::getAccessor(name) + " property. It is parsed "
+                         "from the source document on the first call. This modifies the object, "
+                         "so the first call must not happen from several threads at the same "
+                         "time.");
+        code += materializer(name) + "();";
+    }
+    if (isUpdatedAt) {
+        // The members are mutable, so this neither casts away const nor
+        // detaches shared data
+        accessor.setDocs("Return the time of the last change. A pending timestamp is set to the "
+                         "current time here. This modifies the object, so it must not be read "
+                         "from several threads at the same time.");
+        const QString pending = constMemberAccess("mUpdatedAtPending");
+        code += "if ( " + pending + " ) {";
+        code += "  " + constMemberAccess(v.name()) + " = QDateTime::currentDateTime();";
+        code += "  " + pending + " = false;";
+        code += '}';
+        code += "return " + constMemberAccess(v.name()) + ';';
+    } else {
+        code += "return " + memberAccess(v.name()) + ';';
+    }
+    accessor.setBody(code);
     c.addFunction(accessor);
 }
 
-void Creator::createCrudFunctions(KODE::Class &c, const QString &type)
+void Creator::createMaterializer(KODE::Class &c, const QString &type, const QString &name,
+                                 const QString &pendingMember)
+{
+    const bool isList = type.endsWith("::List");
+    const QString itemType = isList ? type.left(type.length() - 6) : type;
+    const QString member = "self->" + memberAccess("m" + Namer::getClassName(name));
+    const QString pending = memberAccess(pendingMember);
+
+    KODE::Function materialize(materializer(name), "void");
+    materialize.setConst(true);
+    materialize.setAccess(KODE::Function::Private);
+
+    KODE::Code code;
+    code += "if ( " + pending + (isList ? ".isEmpty()" : ".isNull()") + " ) {";
+    code += "  return;";
+    code += '}';
+    code += "// Parsing only fills in data which is logically already there";
+    code += c.name() + " *self = const_cast<" + c.name() + " *>( this );";
+    if (isList) {
+        code += "const QList<QDomElement> elements = " + pending + ';';
+        code += "self->" + pending + ".clear();";
+        code += member + ".reserve( " + member + ".size() + elements.size() );";
+        code += "for ( const QDomElement &e : elements ) {";
+        code.indent();
+        code += "bool ok;";
+        code += itemType + " o = " + itemType + "::parseElement( e, &ok );";
+        code += "if ( ok ) " + member + ".append( o );";
+        code.unindent();
+        code += '}';
+    } else {
+        code += "const QDomElement e = " + pending + ';';
+        code += "self->" + pending + " = QDomElement();";
+        code += "bool ok;";
+        code += itemType + " o = " + itemType + "::parseElement( e, &ok );";
+        code += "if ( ok ) " + member + " = std::move( o );";
+    }
+    materialize.setBody(code);
+
+    c.addFunction(materialize);
+}
+
+void Creator::createTimestampFunctions(KODE::Class &c, KODE::Code &constructorCode,
+                                       bool hasCreatedAt, bool hasUpdatedAt)
+{
+    // An object is created once, so CreatedAt is set right away. A new object
+    // counts as updated at the same time.
+    if (hasCreatedAt) {
+        constructorCode += "const QDateTime now = QDateTime::currentDateTime();";
+        constructorCode += memberAccess("mCreatedAt") + " = now;";
+    }
+
+    if (!hasUpdatedAt) {
+        return;
+    }
+
+    // Getting the current time is expensive, so UpdatedAt is only marked as
+    // pending when the object changes. It is set when it is read or the
+    // changes are committed.
+    KODE::MemberVariable pending("UpdatedAtPending", "mutable bool");
+    c.addMemberVariable(pending);
+
+    const QString flag = memberAccess(pending.name());
+
+    if (hasCreatedAt) {
+        constructorCode += memberAccess("mUpdatedAt") + " = now;";
+        constructorCode += flag + " = false;";
+    } else {
+        constructorCode += flag + " = true;";
+    }
+
+    KODE::Function committer("commit", "void");
+    committer.setDocs("Set the UpdatedAt timestamp to the current time, if the object has been "
+                      "changed since the last commit.");
+
+    KODE::Code code;
+    code += "if ( " + flag + " ) {";
+    code += "  " + memberAccess("mUpdatedAt") + " = QDateTime::currentDateTime();";
+    code += "  " + flag + " = false;";
+    code += '}';
+    committer.setBody(code);
+
+    KODE::Function clearer("clearPendingTimestamps", "void");
+    clearer.setDocs("Keep the UpdatedAt timestamp unchanged, even if the object has been changed "
+                    "since the last commit.");
+    clearer.addBodyLine(flag + " = false;");
+
+    c.addFunction(committer);
+    c.addFunction(clearer);
+}
+
+void Creator::createCrudFunctions(KODE::Class &c, KODE::Code &constructorCode,
+                                  const QString &type, bool targetHasUpdatedTimestamp,
+                                  const QString &hashesMember, const QString &timestampUpdate)
 {
     if (!c.hasEnum("Flags")) {
         QStringList enumValues;
@@ -170,17 +507,61 @@ void Creator::createCrudFunctions(KODE::Class &c, const QString &type)
         c.addEnum(flags);
     }
 
+    const QString listMember = memberAccess("m" + type + "List");
+    const QString items = constMemberAccess("m" + type + "List");
+    const QString index = memberAccess("m" + type + "Index");
+    const QString constIndex = constMemberAccess("m" + type + "Index");
+    const QString valid = memberAccess("m" + type + "IndexValid");
+
+    // Changing the list makes the source hashes used by update() stale
+    QString discardHashes;
+    if (!hashesMember.isEmpty()) {
+        discardHashes = memberAccess(hashesMember) + ".clear();";
+    }
+
+    // Maps ids to the position of the first item with the id. It is built on
+    // demand and invalidated when positions change.
+    c.addHeaderInclude("QHash");
+    c.addMemberVariable(KODE::MemberVariable(type + "Index", "QHash<QString, int>"));
+    c.addMemberVariable(KODE::MemberVariable(type + "IndexValid", "bool"));
+    constructorCode += valid + " = false;";
+
+    KODE::Function indexer("ensure" + type + "Index", "void");
+    indexer.setAccess(KODE::Function::Private);
+
+    KODE::Code code;
+    if (lazyParse()) {
+        code += materializer(type + "List") + "();";
+    }
+    // Checking the flag must not detach shared data, only rebuilding does
+    code += "if ( " + constMemberAccess("m" + type + "IndexValid") + " ) {";
+    code += "  return;";
+    code += '}';
+    code += "const " + type + "::List &items = " + items + ';';
+    code += index + ".clear();";
+    code += index + ".reserve( items.size() );";
+    code += "for ( int i = 0; i < items.size(); ++i ) {";
+    code += "  if ( !" + index + ".contains( items.at( i ).id() ) ) {";
+    code += "    " + index + ".insert( items.at( i ).id(), i );";
+    code += "  }";
+    code += '}';
+    code += valid + " = true;";
+
+    indexer.setBody(code);
+
+    c.addFunction(indexer);
+
     KODE::Function finder("find" + type, type);
 
     finder.addArgument("const QString &id");
     finder.addArgument(KODE::Function::Argument("Flags flags", "Flags_None"));
 
-    QString listMember = "m" + type + "List";
-
-    KODE::Code code;
-    code += "foreach( " + type + " v, " + listMember + " ) {";
-    code += "  if ( v.id() == id ) return v;";
-    code += "}";
+    code.clear();
+    code += indexer.name() + "();";
+    code += "const QHash<QString, int>::ConstIterator it = " + constIndex + ".constFind( id );";
+    code += "if ( it != " + constIndex + ".constEnd() ) {";
+    code += "  return " + items + ".at( it.value() );";
+    code += '}';
     code += type + " v;";
     code += "if ( flags == Flags_AutoCreate ) {";
     code += "  v.setId( id );";
@@ -197,14 +578,17 @@ void Creator::createCrudFunctions(KODE::Class &c, const QString &type)
 
     inserter.addArgument("const " + type + " &v");
 
-    code += "int i = 0;";
-    code += "for( ; i < " + listMember + ".size(); ++i ) {";
-    code += "  if ( " + listMember + "[i].id() == v.id() ) {";
-    code += "    " + listMember + "[i] = v;";
-    code += "    return true;";
-    code += "  }";
-    code += "}";
-    code += "if ( i == " + listMember + ".size() ) {";
+    code += indexer.name() + "();";
+    code += "const QHash<QString, int>::ConstIterator it = " + index + ".constFind( v.id() );";
+    code += "if ( it != " + index + ".constEnd() ) {";
+    code += "  " + listMember + "[it.value()] = v;";
+    if (!discardHashes.isEmpty()) {
+        code += "  " + discardHashes;
+    }
+    if (!timestampUpdate.isEmpty()) {
+        code += "  " + timestampUpdate;
+    }
+    code += "} else {";
     code += "  add" + type + "( v );";
     code += "}";
     code += "return true;";
@@ -213,24 +597,387 @@ void Creator::createCrudFunctions(KODE::Class &c, const QString &type)
 
     c.addFunction(inserter);
 
+    c.addInclude("utility");
+
     KODE::Function remover("remove", "bool");
+    remover.setDocs("Remove the item with the id of v. The last item of the list takes its "
+                    "place, unless the list contains duplicate ids.");
 
     remover.addArgument("const " + type + " &v");
 
     code.clear();
 
-    code += type + "::List::Iterator it;";
-    code += "for( it = " + listMember + ".begin(); it != " + listMember + ".end(); ++it ) {";
-    code += "  if ( (*it).id() == v.id() ) break;";
-    code += "}";
-    code += "if ( it != " + listMember + ".end() ) {";
-    code += "  " + listMember + ".erase( it );";
-    code += "}";
+    // Moving the last item into the gap keeps the index valid, so removing
+    // items one by one doesn't rebuild it every time. That only works when
+    // every item is in the index, i.e. when the ids are unique.
+    code += indexer.name() + "();";
+    code += "QHash<QString, int> &index = " + index + ';';
+    code += type + "::List &items = " + listMember + ';';
+    code += "const QHash<QString, int>::Iterator it = index.find( v.id() );";
+    code += "if ( it == index.end() ) {";
+    code += "  return true;";
+    code += '}';
+    code += "const int position = it.value();";
+    if (!discardHashes.isEmpty()) {
+        code += discardHashes;
+    }
+    if (!timestampUpdate.isEmpty()) {
+        code += timestampUpdate;
+    }
+    code += "if ( index.size() != items.size() ) {";
+    code.indent();
+    code += "items.removeAt( position );";
+    code += valid + " = false;";
+    code += "return true;";
+    code.unindent();
+    code += '}';
+    code += "index.erase( it );";
+    code += "const int last = items.size() - 1;";
+    code += "if ( position != last ) {";
+    code += "  items[position] = std::move( items[last] );";
+    code += "  index[items.at( position ).id()] = position;";
+    code += '}';
+    code += "items.removeLast();";
     code += "return true;";
 
     remover.setBody(code);
 
     c.addFunction(remover);
+
+    createBatchCrudFunctions(c, type, targetHasUpdatedTimestamp, discardHashes, timestampUpdate);
+}
+
+void Creator::createBatchCrudFunctions(KODE::Class &c, const QString &type,
+                                       bool targetHasUpdatedTimestamp,
+                                       const QString &discardHashes,
+                                       const QString &timestampUpdate)
+{
+    const QString listMember = memberAccess("m" + type + "List");
+    const QString index = memberAccess("m" + type + "Index");
+    const QString indexer = "ensure" + type + "Index";
+
+    // All items of a batch get the same timestamp
+    KODE::Code stampLast;
+    KODE::Code stampExisting;
+    if (targetHasUpdatedTimestamp) {
+        c.addInclude("QDateTime");
+        stampLast += "items.last().setUpdatedAt( now );";
+        stampExisting += "items[it.value()].setUpdatedAt( now );";
+    }
+
+    KODE::Function inserter("insertMany", "int");
+    inserter.setDocs("Add the items whose ids are not in the list yet. Returns the number of "
+                     "added items.");
+    inserter.addArgument("const " + type + "::List &batch");
+
+    KODE::Code code;
+    code += indexer + "();";
+    code += type + "::List &items = " + listMember + ';';
+    code += "QHash<QString, int> &index = " + index + ';';
+    if (targetHasUpdatedTimestamp) {
+        code += "const QDateTime now = QDateTime::currentDateTime();";
+    }
+    code += "const int oldSize = items.size();";
+    code += "items.reserve( oldSize + batch.size() );";
+    code += "for ( const " + type + " &v : batch ) {";
+    code.indent();
+    code += "if ( index.contains( v.id() ) ) {";
+    code += "  continue;";
+    code += '}';
+    code += "items.append( v );";
+    code += stampLast;
+    code += "index.insert( v.id(), items.size() - 1 );";
+    code.unindent();
+    code += '}';
+    if (!discardHashes.isEmpty() || !timestampUpdate.isEmpty()) {
+        code += "if ( items.size() != oldSize ) {";
+        if (!discardHashes.isEmpty()) {
+            code += "  " + discardHashes;
+        }
+        if (!timestampUpdate.isEmpty()) {
+            code += "  " + timestampUpdate;
+        }
+        code += '}';
+    }
+    code += "return items.size() - oldSize;";
+
+    inserter.setBody(code);
+
+    c.addFunction(inserter);
+
+    KODE::Function upserter("upsertMany", "void");
+    upserter.setDocs("Replace the items with the ids of the items of the batch and add the "
+                     "items whose ids are not in the list yet.");
+    upserter.addArgument("const " + type + "::List &batch");
+
+    code.clear();
+    code += "if ( batch.isEmpty() ) {";
+    code += "  return;";
+    code += '}';
+    code += indexer + "();";
+    code += type + "::List &items = " + listMember + ';';
+    code += "QHash<QString, int> &index = " + index + ';';
+    if (targetHasUpdatedTimestamp) {
+        code += "const QDateTime now = QDateTime::currentDateTime();";
+    }
+    if (!discardHashes.isEmpty()) {
+        code += discardHashes;
+    }
+    if (!timestampUpdate.isEmpty()) {
+        code += timestampUpdate;
+    }
+    code += "for ( const " + type + " &v : batch ) {";
+    code.indent();
+    code += "const QHash<QString, int>::ConstIterator it = index.constFind( v.id() );";
+    code += "if ( it != index.constEnd() ) {";
+    code.indent();
+    code += "items[it.value()] = v;";
+    code += stampExisting;
+    code.unindent();
+    code += "} else {";
+    code.indent();
+    code += "items.append( v );";
+    code += stampLast;
+    code += "index.insert( v.id(), items.size() - 1 );";
+    code.unindent();
+    code += '}';
+    code.unindent();
+    code += '}';
+
+    upserter.setBody(code);
+
+    c.addFunction(upserter);
+
+    c.addInclude("QSet");
+    c.addInclude("algorithm");
+
+    KODE::Function remover("removeFrom" + type + "List", "int");
+    remover.setDocs("Remove the items with the given ids. Returns the number of removed items.");
+    remover.addArgument("const QStringList &ids");
+
+    code.clear();
+    code += "if ( ids.isEmpty() ) {";
+    code += "  return 0;";
+    code += '}';
+    if (lazyParse()) {
+        code += materializer(type + "List") + "();";
+    }
+    code += "QSet<QString> removedIds;";
+    code += "removedIds.reserve( ids.size() );";
+    code += "for ( const QString &id : ids ) {";
+    code += "  removedIds.insert( id );";
+    code += '}';
+    code += type + "::List &items = " + listMember + ';';
+    code += "const int oldSize = items.size();";
+    code += "items.erase( std::remove_if( items.begin(), items.end(),";
+    code += "                             [&removedIds]( const " + type + " &v ) {";
+    code += "                               return removedIds.contains( v.id() );";
+    code += "                             } ),";
+    code += "             items.end() );";
+    code += "if ( items.size() != oldSize ) {";
+    code += "  " + memberAccess("m" + type + "IndexValid") + " = false;";
+    if (!discardHashes.isEmpty()) {
+        code += "  " + discardHashes;
+    }
+    if (!timestampUpdate.isEmpty()) {
+        code += "  " + timestampUpdate;
+    }
+    code += '}';
+    code += "return oldSize - items.size();";
+
+    remover.setBody(code);
+
+    c.addFunction(remover);
+}
+
+void Creator::createEnumConverters(KODE::Class &c, const Schema::Attribute &a)
+{
+    const QString enumName = Namer::getClassName(a.name()) + "Enum";
+    const QString functionName = KODE::Style::lowerFirst(enumName);
+    const QStringList values = a.enumerationValues();
+
+    QStringList sortedValues = values;
+    std::sort(sortedValues.begin(), sortedValues.end());
+
+    KODE::Function fromName(functionName + "FromName", c.name() + "::" + enumName);
+    fromName.setStatic(true);
+    fromName.setDocs("Return the value of the enum for the XML name. If the name is unknown, ok "
+                     "is set to false and the first value is returned.");
+    fromName.addArgument("const QStringRef &name");
+    fromName.addArgument(KODE::Function::Argument("bool *ok", "nullptr"));
+
+    // The names are QStrings, so values which aren't ASCII compare correctly.
+    // Both QString sorting and QStringRef::compare() use UTF-16 code units.
+    KODE::Code code;
+    code += "static const QString names[] = {";
+    code.indent();
+    for (const QString &value : qAsConst(sortedValues)) {
+        code += "QStringLiteral( \"" + value + "\" ),";
+    }
+    code.unindent();
+    code += "};";
+    code += "static const " + enumName + " values[] = {";
+    code.indent();
+    for (const QString &value : qAsConst(sortedValues)) {
+        code += enumValue(enumName, value) + ',';
+    }
+    code.unindent();
+    code += "};";
+    code.newLine();
+    code += "int first = 0;";
+    code += "int last = int( sizeof( names ) / sizeof( *names ) ) - 1;";
+    code += "while ( first <= last ) {";
+    code.indent();
+    code += "const int middle = ( first + last ) / 2;";
+    code += "const int result = name.compare( names[middle] );";
+    code += "if ( result == 0 ) {";
+    code += "  if ( ok ) *ok = true;";
+    code += "  return values[middle];";
+    code += "} else if ( result < 0 ) {";
+    code += "  last = middle - 1;";
+    code += "} else {";
+    code += "  first = middle + 1;";
+    code += '}';
+    code.unindent();
+    code += '}';
+    code += "if ( ok ) *ok = false;";
+    code += "return " + enumValue(enumName, values.first()) + ';';
+    fromName.setBody(code);
+    c.addFunction(fromName);
+
+    KODE::Function fromNameString(functionName + "FromName", c.name() + "::" + enumName);
+    fromNameString.setStatic(true);
+    fromNameString.addArgument("const QString &name");
+    fromNameString.addArgument(KODE::Function::Argument("bool *ok", "nullptr"));
+    fromNameString.addBodyLine("return " + functionName + "FromName( QStringRef( &name ), ok );");
+    c.addFunction(fromNameString);
+
+    KODE::Function toName(functionName + "ToName", "QString");
+    toName.setStatic(true);
+    toName.setDocs("Return the XML name of the enum value.");
+    toName.addArgument(enumName + " value");
+
+    code.clear();
+    code += "static const QString names[] = {";
+    code.indent();
+    for (const QString &value : values) {
+        code += "QStringLiteral( \"" + value + "\" ),";
+    }
+    code.unindent();
+    code += "};";
+    code += "switch ( value ) {";
+    for (int i = 0; i < values.size(); ++i) {
+        code += "case " + enumValue(enumName, values.at(i)) + ':';
+        code += "  return names[" + QString::number(i) + "];";
+    }
+    code += '}';
+    code += "return QString();";
+    toName.setBody(code);
+    c.addFunction(toName);
+}
+
+void Creator::createBinaryFunctions(KODE::Class &c, const ClassDescription &description)
+{
+    c.addHeaderInclude("QDataStream");
+
+    KODE::Function writer("writeBinary", "void");
+    writer.setConst(true);
+    writer.setDocs("Write object to the data stream in the format read by readBinary().");
+    writer.addArgument("QDataStream &stream");
+
+    KODE::Function reader("readBinary", c.name());
+    reader.setStatic(true);
+    reader.setDocs("Read object written by writeBinary() from the data stream.");
+    reader.addArgument("QDataStream &stream");
+    reader.addArgument(KODE::Function::Argument("bool *ok", "nullptr"));
+
+    KODE::Code writeCode;
+    KODE::Code readCode;
+
+    readCode += c.name() + " result;";
+
+    // The members are read directly, so reading doesn't update timestamps.
+    // Writing uses the accessors, which parse lazily parsed children.
+    const auto properties = description.properties();
+    for (const ClassProperty &p : properties) {
+        if (p.isList()) {
+            const QString listName = p.name() + "List";
+            const QString accessor = Namer::getAccessor(listName) + "()";
+            const QString member = "result." + memberAccess("m" + Namer::getClassName(listName));
+
+            writeCode += "stream << qint32( " + accessor + ".size() );";
+            writeCode += "for ( const " + p.type() + " &v : " + accessor + " ) {";
+            writeCode += "  v.writeBinary( stream );";
+            writeCode += '}';
+
+            readCode += '{';
+            readCode.indent();
+            readCode += "qint32 size;";
+            readCode += "stream >> size;";
+            readCode += "if ( stream.status() != QDataStream::Ok || size < 0 ) {";
+            readCode += "  if ( ok ) *ok = false;";
+            readCode += "  return " + c.name() + "();";
+            readCode += '}';
+            readCode += "// The size is not trusted for allocating memory up front";
+            readCode += member + ".reserve( qMin( size, 1024 ) );";
+            readCode += "for ( qint32 i = 0; i < size; ++i ) {";
+            readCode.indent();
+            readCode += "bool itemOk;";
+            readCode += member + ".append( " + p.type() + "::readBinary( stream, &itemOk ) );";
+            readCode += "if ( !itemOk ) {";
+            readCode += "  if ( ok ) *ok = false;";
+            readCode += "  return " + c.name() + "();";
+            readCode += '}';
+            readCode.unindent();
+            readCode += '}';
+            readCode.unindent();
+            readCode += '}';
+        } else {
+            const QString accessor = Namer::getAccessor(p.name()) + "()";
+            const QString member = "result." + memberAccess("m" + Namer::getClassName(p.name()));
+
+            if (mProcessedClasses.contains(p.type())) {
+                writeCode += accessor + ".writeBinary( stream );";
+
+                readCode += '{';
+                readCode.indent();
+                readCode += "bool memberOk;";
+                readCode += member + " = " + p.type() + "::readBinary( stream, &memberOk );";
+                readCode += "if ( !memberOk ) {";
+                readCode += "  if ( ok ) *ok = false;";
+                readCode += "  return " + c.name() + "();";
+                readCode += '}';
+                readCode.unindent();
+                readCode += '}';
+            } else if (p.type().endsWith("Enum")) {
+                writeCode += "stream << qint32( " + accessor + " );";
+
+                readCode += '{';
+                readCode.indent();
+                readCode += "qint32 value;";
+                readCode += "stream >> value;";
+                readCode += member + " = static_cast<" + p.type() + ">( value );";
+                readCode.unindent();
+                readCode += '}';
+            } else {
+                writeCode += "stream << " + accessor + ';';
+
+                readCode += "stream >> " + member + ';';
+            }
+        }
+    }
+
+    if (mCreateCrudFunctions && description.hasProperty("UpdatedAt")) {
+        readCode += "result.clearPendingTimestamps();";
+    }
+    readCode += "if ( ok ) *ok = stream.status() == QDataStream::Ok;";
+    readCode += "return result;";
+
+    writer.setBody(writeCode);
+    reader.setBody(readCode);
+
+    c.addFunction(writer);
+    c.addFunction(reader);
 }
 
 ClassDescription Creator::createClassDescription(const Schema::Element &element)
@@ -239,7 +986,7 @@ ClassDescription Creator::createClassDescription(const Schema::Element &element)
 
     const auto attributeRelations = element.attributeRelations();
     for (const Schema::Relation &r : attributeRelations) {
-        Schema::Attribute a = mDocument.attribute(r, element.name());
+        const Schema::Attribute &a = mDocument.attribute(r, element.name());
         if (a.enumerationValues().count()) {
             if (!description.hasEnum(a.name())) {
                 description.addEnum(KODE::Enum(Namer::getClassName(a.name()) + "Enum",
@@ -258,7 +1005,7 @@ ClassDescription Creator::createClassDescription(const Schema::Element &element)
 
     const auto elementRelations = element.elementRelations();
     for (const Schema::Relation &r : elementRelations) {
-        Schema::Element targetElement = mDocument.element(r);
+        const Schema::Element &targetElement = mDocument.element(r);
 
         QString targetClassName = Namer::getClassName(targetElement.name());
 
@@ -296,6 +1043,9 @@ ClassDescription Creator::createClassDescription(const Schema::Element &element)
                 if (targetClassFlags.hasId()) {
                     p.setTargetHasId(true);
                 }
+                if (targetClassFlags.hasUpdatedTimestamp()) {
+                    p.setTargetHasUpdatedTimestamp(true);
+                }
 
                 description.addProperty(p);
             } else {
@@ -335,29 +1085,27 @@ void Creator::createClass(const Schema::Element &element)
         c.setExportDeclaration(mExportDeclaration);
     }
 
+    if (mUseSharedData) {
+        c.addHeaderInclude("QSharedData");
+        c.setUseSharedData(true, "d");
+    }
+
     bool hasCreatedAt = description.hasProperty("CreatedAt");
     bool hasUpdatedAt = description.hasProperty("UpdatedAt");
 
+    // Initialization of the members which need it, collected from all functions
+    KODE::Code constructorCode;
+
     if (mCreateCrudFunctions) {
         if (hasCreatedAt || hasUpdatedAt) {
-            KODE::Function constructor(className, "");
-            KODE::Code code;
-            code += "QDateTime now = QDateTime::currentDateTime();";
-            if (hasCreatedAt) {
-                code += "setCreatedAt( now );";
-            }
-            if (hasUpdatedAt) {
-                code += "setUpdatedAt( now );";
-            }
-            constructor.setBody(code);
-            c.addFunction(constructor);
+            createTimestampFunctions(c, constructorCode, hasCreatedAt, hasUpdatedAt);
         }
 
         if (description.hasProperty("Id")) {
             KODE::Function isValid("isValid", "bool");
             isValid.setConst(true);
             KODE::Code code;
-            code += "return !mId.isEmpty();";
+            code += "return !" + memberAccess("mId") + ".isEmpty();";
             isValid.setBody(code);
             c.addFunction(isValid);
         }
@@ -370,44 +1118,433 @@ void Creator::createClass(const Schema::Element &element)
             c.addHeaderInclude("QList");
             QString listName = p.name() + "List";
 
+            QString listMember = memberAccess('m' + KODE::Style::upperFirst(listName));
+
+            // The id index of the CRUD functions is kept up to date by the
+            // adders, as long as it has been built. afterAdd holds the code
+            // the adders run after appending an item.
+            const bool indexed = mCreateCrudFunctions && p.targetHasId();
+            const QString indexMember = indexed ? "m" + p.type() + "Index" : QString();
+            KODE::Code afterAdd;
+            if (indexed) {
+                const QString index = memberAccess(indexMember);
+                afterAdd += "if ( " + memberAccess(indexMember + "Valid") + " && !" + index
+                        + ".contains( " + listMember + ".last().id() ) ) {";
+                afterAdd += "  " + index + ".insert( " + listMember + ".last().id(), "
+                        + listMember + ".size() - 1 );";
+                afterAdd += '}';
+            }
+
+            // The root lists remember the source hashes of their items for
+            // update(). Any change makes them stale, so they are discarded.
+            const bool hashed =
+                    incremental() && element.identifier() == mDocument.startElement().identifier();
+            const QString hashesMember = hashed ? "m" + p.type() + "ListHashes" : QString();
+            if (hashed) {
+                afterAdd += memberAccess(hashesMember) + ".clear();";
+            }
+
+            // Changing the list is a change of the object, like calling a setter
+            QString timestampUpdate;
+            if (mCreateCrudFunctions && hasUpdatedAt) {
+                timestampUpdate = memberAccess("mUpdatedAtPending") + " = true;";
+                afterAdd += timestampUpdate;
+            }
+
             KODE::Function adder("add" + p.type(), "void");
             adder.addArgument("const " + p.type() + " &v");
 
             KODE::Code code;
-            code += 'm' + KODE::Style::upperFirst(listName) + ".append( v );";
+            if (lazyParse()) {
+                code += materializer(listName) + "();";
+            }
+            code += listMember + ".append( v );";
+            code += afterAdd;
 
             adder.setBody(code);
 
             c.addFunction(adder);
 
-            createProperty(c, description, p.type() + "::List", listName);
+            // QList has no rvalue append(), so move into a freshly appended element
+            KODE::Function moveAdder("add" + p.type(), "void");
+            moveAdder.addArgument(p.type() + " &&v");
+
+            code.clear();
+            if (lazyParse()) {
+                code += materializer(listName) + "();";
+            }
+            code += listMember + ".append( " + p.type() + "() );";
+            code += listMember + ".last() = std::move( v );";
+            code += afterAdd;
+
+            moveAdder.setBody(code);
+
+            c.addFunction(moveAdder);
+
+            KODE::Function reserver("reserve" + KODE::Style::upperFirst(listName), "void");
+            reserver.setDocs("Reserve space for at least size elements in the list.");
+            reserver.addArgument("int size");
+
+            code.clear();
+            if (lazyParse()) {
+                code += materializer(listName) + "();";
+            }
+            code += listMember + ".reserve( size );";
+
+            reserver.setBody(code);
+
+            c.addFunction(reserver);
+
+            createProperty(c, description, p.type() + "::List", listName, lazyParse(),
+                           indexMember, hashesMember);
+
+            // Hashes of the source of the items, used by update()
+            if (hashed) {
+                c.addHeaderInclude("QVector");
+                c.addMemberVariable(KODE::MemberVariable(p.type() + "ListHashes",
+                                                         "QVector<quint64>"));
+            }
 
             if (mCreateCrudFunctions && p.targetHasId()) {
-                createCrudFunctions(c, p.type());
+                createCrudFunctions(c, constructorCode, p.type(), p.targetHasUpdatedTimestamp(),
+                                    hashesMember, timestampUpdate);
             }
         } else {
-            createProperty(c, description, p.type(), p.name());
+            // Classes being processed are complex children, everything else is
+            // converted from text
+            const bool lazy = lazyParse() && mProcessedClasses.contains(p.type());
+            createProperty(c, description, p.type(), p.name(), lazy);
         }
     }
 
+    if (!constructorCode.isEmpty()) {
+        KODE::Function constructor(c.name(), "");
+        constructor.setBody(constructorCode);
+        c.addFunction(constructor);
+    }
+
     const auto descEnums = description.enums();
     for (const KODE::Enum &e : descEnums) {
         c.addEnum(e);
     }
 
+    QStringList enumAttributes;
+    const auto attributeRelations = element.attributeRelations();
+    for (const Schema::Relation &r : attributeRelations) {
+        const Schema::Attribute &a = mDocument.attribute(r, element.name());
+        if (a.enumerationValues().count() && !enumAttributes.contains(a.name())) {
+            enumAttributes.append(a.name());
+            createEnumConverters(c, a);
+        }
+    }
+
     if (mUseQEnums)
         c.setQGadget(c.enums().count());
 
+    if (mCreateBinaryFunctions)
+        createBinaryFunctions(c, description);
+
     if (mCreateParserFunctions)
         createElementParser(c, element);
 
     if (mCreateWriterFunctions) {
         WriterCreator writerCreator(mFile, mDocument, mDtd);
+        writerCreator.setParallelWrite(mParallelWrite);
         writerCreator.createElementWriter(c, element);
     }
+
+    if (mCreateJsonFunctions) {
+        JsonCreator jsonCreator(mFile, mDocument);
+        jsonCreator.setClearPendingTimestamps(hasPendingTimestamps(element));
+        jsonCreator.createJsonFunctions(c, element);
+    }
+
+    if (mCreateVisitor && element.identifier() == mDocument.startElement().identifier()) {
+        createVisitorClass(element);
+    }
+
+    if (mCreateArena) {
+        createArenaAllocator(c);
+    }
+
+    mFile.insertClass(c);
+}
+
+void Creator::createVisitorClass(const Schema::Element &element)
+{
+    KODE::Class c(visitorClassName());
+
+    if (!mExportDeclaration.isEmpty()) {
+        c.setExportDeclaration(mExportDeclaration);
+    }
+
+    c.setDocs("Receives the items of the lists contained in "
+              + Namer::getClassName(element.name())
+              + " one by one while the document is parsed. Reimplement the functions for the "
+                "items you are interested in.");
+
+    KODE::Function destructor('~' + c.name(), "");
+    destructor.setVirtualMode(KODE::Function::Virtual);
+    c.addFunction(destructor);
+
+    const auto elementRelations = element.elementRelations();
+    for (const Schema::Relation &r : elementRelations) {
+        if (!r.isList()) {
+            continue;
+        }
+        QString type = Namer::getClassName(r.target());
+
+        KODE::Function callback("on" + type, "void");
+        callback.setVirtualMode(KODE::Function::Virtual);
+        callback.addArgument("const " + type + " &v");
+        callback.addBodyLine("Q_UNUSED( v );");
+        c.addFunction(callback);
+    }
+
     mFile.insertClass(c);
 }
 
+void Creator::createArenaAllocator(KODE::Class &c)
+{
+    const QString arenaClassName =
+            Namer::getClassName(mDocument.startElement().name()) + "Arena";
+
+    c.addHeaderInclude("cstddef");
+
+    KODE::Function allocator("operator new", "void *");
+    allocator.setStatic(true);
+    allocator.setDocs("Allocate from the current arena, if there is one.");
+    allocator.addArgument("size_t size");
+    allocator.addBodyLine("return " + arenaClassName + "::allocateObject( size );");
+    c.addFunction(allocator);
+
+    KODE::Function deallocator("operator delete", "void");
+    deallocator.setStatic(true);
+    deallocator.addArgument("void *object");
+    deallocator.addBodyLine(arenaClassName + "::releaseObject( object );");
+    c.addFunction(deallocator);
+
+    // The class specific operator new hides the global placement new, which
+    // containers like QVector use to construct elements in their own memory
+    KODE::Function placementAllocator("operator new", "void *");
+    placementAllocator.setStatic(true);
+    placementAllocator.setDocs("Construct the object in memory owned by the caller.");
+    placementAllocator.addArgument("size_t size");
+    placementAllocator.addArgument("void *p");
+    placementAllocator.addBodyLine("Q_UNUSED( size );");
+    placementAllocator.addBodyLine("return p;");
+    c.addFunction(placementAllocator);
+
+    KODE::Function placementDeallocator("operator delete", "void");
+    placementDeallocator.setStatic(true);
+    placementDeallocator.addArgument("void *object");
+    placementDeallocator.addArgument("void *p");
+    placementDeallocator.addBodyLine("Q_UNUSED( object );");
+    placementDeallocator.addBodyLine("Q_UNUSED( p );");
+    c.addFunction(placementDeallocator);
+}
+
+void Creator::createArenaClasses(const Schema::Element &element)
+{
+    const QString rootClassName = Namer::getClassName(element.name());
+
+    KODE::Class arena(rootClassName + "Arena");
+
+    if (!mExportDeclaration.isEmpty()) {
+        arena.setExportDeclaration(mExportDeclaration);
+    }
+
+    arena.setDocs("Allocates memory for the objects created by the containers of the generated "
+                  "classes in large blocks. The memory is released when the arena is destroyed. "
+                  "Data owned by the objects, like strings, list arrays and shared private "
+                  "data, is still allocated on the heap. An arena is used by one thread at a "
+                  "time.");
+
+    arena.addHeaderInclude("cstddef");
+    arena.addHeaderInclude("memory");
+    arena.addHeaderInclude("vector");
+    arena.addInclude("cstdlib");
+    arena.addInclude("new");
+    arena.addInclude("utility");
+
+    KODE::MemberVariable blocks("Blocks", "std::vector<std::unique_ptr<char[]>>");
+    arena.addMemberVariable(blocks);
+    KODE::MemberVariable used("Used", "size_t");
+    arena.addMemberVariable(used);
+    KODE::MemberVariable available("Available", "size_t");
+    arena.addMemberVariable(available);
+
+    KODE::Function constructor(arena.name(), "");
+    constructor.addBodyLine(used.name() + " = 0;");
+    constructor.addBodyLine(available.name() + " = 0;");
+    arena.addFunction(constructor);
+
+    KODE::Function allocate("allocate", "void *");
+    allocate.setDocs("Return size bytes aligned for any type.");
+    allocate.addArgument("size_t size");
+
+    KODE::Code code;
+    code += "const size_t alignment = alignof( std::max_align_t );";
+    code += "const size_t blockSize = 64 * 1024;";
+    code += "size = ( size + alignment - 1 ) & ~( alignment - 1 );";
+    code += "if ( size > blockSize / 4 ) {";
+    code.indent();
+    code += "// Large objects get a block of their own, kept in front of the current block";
+    code += "std::unique_ptr<char[]> block( new char[size] );";
+    code += "char *p = block.get();";
+    code += blocks.name() + ".insert( " + blocks.name() + ".empty() ? " + blocks.name()
+            + ".end() : " + blocks.name() + ".end() - 1, std::move( block ) );";
+    code += "return p;";
+    code.unindent();
+    code += '}';
+    code += "if ( size > " + available.name() + " ) {";
+    code.indent();
+    code += blocks.name() + ".emplace_back( new char[blockSize] );";
+    code += used.name() + " = 0;";
+    code += available.name() + " = blockSize;";
+    code.unindent();
+    code += '}';
+    code += "void *p = " + blocks.name() + ".back().get() + " + used.name() + ';';
+    code += used.name() + " += size;";
+    code += available.name() + " -= size;";
+    code += "return p;";
+    allocate.setBody(code);
+    arena.addFunction(allocate);
+
+    KODE::Function currentSlot("currentSlot", arena.name() + " *&");
+    currentSlot.setStatic(true);
+    currentSlot.setAccess(KODE::Function::Private);
+    currentSlot.addBodyLine("static thread_local " + arena.name() + " *arena = nullptr;");
+    currentSlot.addBodyLine("return arena;");
+    arena.addFunction(currentSlot);
+
+    KODE::Function current("current", arena.name() + " *");
+    current.setStatic(true);
+    current.setDocs("Return the arena used by the current thread or null, if objects are "
+                    "allocated on the heap.");
+    current.addBodyLine("return currentSlot();");
+    arena.addFunction(current);
+
+    KODE::Function setCurrent("setCurrent", arena.name() + " *");
+    setCurrent.setStatic(true);
+    setCurrent.setDocs("Make arena the arena used by the current thread. Pass null to allocate "
+                       "on the heap. Returns the previous arena.");
+    setCurrent.addArgument(arena.name() + " *arena");
+    setCurrent.addBodyLine(arena.name() + " *previous = currentSlot();");
+    setCurrent.addBodyLine("currentSlot() = arena;");
+    setCurrent.addBodyLine("return previous;");
+    arena.addFunction(setCurrent);
+
+    // Every object starts with a header holding the arena it was allocated
+    // from, so it can be released without knowing the current arena.
+    KODE::Function allocateObject("allocateObject", "void *");
+    allocateObject.setStatic(true);
+    allocateObject.addArgument("size_t size");
+
+    code.clear();
+    code += "const size_t header = alignof( std::max_align_t );";
+    code += arena.name() + " *arena = current();";
+    code += "char *p = static_cast<char *>( arena ? arena->allocate( header + size )";
+    code += "                                     : std::malloc( header + size ) );";
+    code += "if ( !p ) {";
+    code += "  throw std::bad_alloc();";
+    code += '}';
+    code += "*reinterpret_cast<" + arena.name() + " **>( p ) = arena;";
+    code += "return p + header;";
+    allocateObject.setBody(code);
+    arena.addFunction(allocateObject);
+
+    KODE::Function releaseObject("releaseObject", "void");
+    releaseObject.setStatic(true);
+    releaseObject.addArgument("void *object");
+
+    code.clear();
+    code += "if ( !object ) {";
+    code += "  return;";
+    code += '}';
+    code += "char *p = static_cast<char *>( object ) - alignof( std::max_align_t );";
+    code += "// Objects allocated from an arena are released together with the arena";
+    code += "if ( !*reinterpret_cast<" + arena.name() + " **>( p ) ) {";
+    code += "  std::free( p );";
+    code += '}';
+    releaseObject.setBody(code);
+    arena.addFunction(releaseObject);
+
+    mFile.insertClass(arena);
+
+    KODE::Class document(rootClassName + "Document");
+
+    if (!mExportDeclaration.isEmpty()) {
+        document.setExportDeclaration(mExportDeclaration);
+    }
+
+    document.setDocs("Owns a parsed " + rootClassName + " together with the arena holding its "
+                     "objects. The objects returned by root() are views into the arena and must "
+                     "not outlive the document and its copies.");
+
+    document.addHeaderInclude("QSharedPointer");
+    document.addInclude("utility");
+
+    KODE::MemberVariable documentArena("Arena", "QSharedPointer<" + arena.name() + '>');
+    document.addMemberVariable(documentArena);
+    KODE::MemberVariable root("Root", rootClassName);
+    document.addMemberVariable(root);
+
+    KODE::Function documentConstructor(document.name(), "");
+    documentConstructor.addBodyLine(documentArena.name() + ".reset( new " + arena.name()
+                                    + " );");
+    document.addFunction(documentConstructor);
+
+    KODE::Function rootAccessor("root", "const " + rootClassName + " &");
+    rootAccessor.setConst(true);
+    rootAccessor.addBodyLine("return " + root.name() + ';');
+    document.addFunction(rootAccessor);
+
+    if (mCreateParserFunctions) {
+        // Parser function, its arguments and the names of the arguments
+        QList<QStringList> parsers;
+        parsers.append(QStringList() << "parseFile"
+                                     << "const QString &filename"
+                                     << "filename");
+        parsers.append(QStringList() << "parseString"
+                                     << "const QString &data"
+                                     << "data");
+        parsers.append(QStringList() << "parseBuffer"
+                                     << "const char *data, size_t size"
+                                     << "data, size");
+
+        for (const QStringList &p : qAsConst(parsers)) {
+            KODE::Function parser(p.at(0), "bool");
+            const QStringList arguments = p.at(1).split(", ");
+            for (const QString &argument : arguments) {
+                parser.addArgument(argument);
+            }
+
+            code.clear();
+            code += "QSharedPointer<" + arena.name() + "> arena( new " + arena.name() + " );";
+            code += arena.name() + " *previous = " + arena.name()
+                    + "::setCurrent( arena.data() );";
+            code += "bool ok = false;";
+            code += rootClassName + " result = " + rootClassName + "::" + p.at(0) + "( " + p.at(2)
+                    + ", &ok );";
+            code += arena.name() + "::setCurrent( previous );";
+            code += "if ( ok ) {";
+            code += "  " + root.name() + " = std::move( result );";
+            code += "  " + documentArena.name() + " = arena;";
+            code += '}';
+            code += "return ok;";
+            parser.setBody(code);
+
+            parser.setDocs("Parse the document with all its objects allocated from a new arena. "
+                           "On success the previous content is replaced.");
+
+            document.addFunction(parser);
+        }
+    }
+
+    mFile.insertClass(document);
+}
+
 void Creator::createElementParser(KODE::Class &c, const Schema::Element &e)
 {
     ParserCreator *parserCreator = 0;
@@ -417,6 +1554,10 @@ void Creator::createElementParser(KODE::Class &c, const Schema::Element &e)
     case XmlParserDomExternal:
         parserCreator = new ParserCreatorDom(this);
         break;
+    case XmlParserStream:
+    case XmlParserStreamExternal:
+        parserCreator = new ParserCreatorStream(this);
+        break;
     }
 
     if (parserCreator == 0) {
@@ -466,8 +1607,18 @@ void Creator::createFileParser(const Schema::Element &element)
     case XmlParserDomExternal:
         parserCreator = new ParserCreatorDom(this);
         break;
+    case XmlParserStream:
+    case XmlParserStreamExternal: {
+        ParserCreatorStream *streamParserCreator = new ParserCreatorStream(this);
+        if (incremental()) {
+            streamParserCreator->createUpdateFunction(element);
+        }
+        parserCreator = streamParserCreator;
+        break;
+    }
     }
 
+    parserCreator->createBufferParser(element);
     parserCreator->createFileParser(element);
     parserCreator->createStringParser(element);
 
@@ -482,6 +1633,10 @@ void Creator::printFiles(KODE::Printer &printer)
 
         parserFile.clearCode();
 
+        for (const KODE::Function &f : qAsConst(mParserHelpers)) {
+            parserFile.addFileFunction(f);
+        }
+
         mParserClass.addHeaderInclude(file().filenameHeader());
         parserFile.insertClass(mParserClass);
 
@@ -509,7 +1664,7 @@ void Creator::printFiles(KODE::Printer &printer)
 
 bool Creator::externalParser() const
 {
-    return mXmlParserType == XmlParserDomExternal;
+    return mXmlParserType == XmlParserDomExternal || mXmlParserType == XmlParserStreamExternal;
 }
 
 bool Creator::externalWriter() const
@@ -532,6 +1687,21 @@ KODE::Class &Creator::parserClass()
     return mParserClass;
 }
 
+void Creator::addParserHelper(const KODE::Function &function)
+{
+    for (const KODE::Function &f : qAsConst(mParserHelpers)) {
+        if (f.name() == function.name()) {
+            return;
+        }
+    }
+
+    mParserHelpers.append(function);
+
+    if (!externalParser()) {
+        mFile.addFileFunction(function);
+    }
+}
+
 QString Creator::errorStream() const
 {
     if (useKde()) {
@@ -550,6 +1720,21 @@ QString Creator::debugStream() const
     }
 }
 
+QString Creator::stringLiteral(const QString &text)
+{
+    return "QStringLiteral( \"" + text + "\" )";
+}
+
+QString Creator::comparisonLiteral(const QString &text)
+{
+    for (const QChar c : text) {
+        if (c.unicode() >= 128) {
+            return stringLiteral(text);
+        }
+    }
+    return "QLatin1String( \"" + text + "\" )";
+}
+
 void Creator::create()
 {
     Schema::Element startElement = mDocument.startElement();
@@ -559,6 +1744,13 @@ void Creator::create()
     //  setDtd( schemaFilename.replace( "rng", "dtd" ) );
     if (mCreateWriterFunctions)
         createFileWriter(startElement);
+    if (mCreateArena)
+        createArenaClasses(startElement);
+    if (mCreateJsonFunctions) {
+        JsonCreator jsonCreator(mFile, mDocument);
+        jsonCreator.createDocumentFunctions(Namer::getClassName(startElement.name()),
+                                            errorStream());
+    }
 
     createListTypedefs();
 }
@@ -608,3 +1800,281 @@ Creator *ParserCreator::creator() const
 {
     return mCreator;
 }
+
+QString ParserCreator::stringToDataConverter(const QString &data, Schema::Node::Type type)
+{
+    QString converter;
+    if (type == Schema::Element::Int) {
+        converter = data + ".toInt()";
+    } else if (type == Schema::Element::UnsignedLong) {
+        converter = data + ".toULongLong()";
+    } else if (type == Schema::Element::Integer) {
+        converter = data + ".toLongLong()";
+    } else if (type == Schema::Element::Decimal) {
+        converter = data + ".toDouble()";
+    } else if (type == Schema::Element::Boolean) {
+        converter = "( " + data + " == QLatin1String( \"1\" ) || " + data
+                + " == QLatin1String( \"true\" ) )";
+    } else if (type == Schema::Element::Date) {
+        converter = "QDate::fromString( " + data + ", " + Creator::stringLiteral("yyyyMMdd") + " )";
+    } else if (type == Schema::Element::DateTime) {
+        converter = "QDateTime::fromString( " + data + ", "
+                + Creator::stringLiteral("yyyyMMddThhmmssZ") + " )";
+    } else {
+        converter = data;
+    }
+    return converter;
+}
+
+bool ParserCreator::isNumberType(Schema::Node::Type type)
+{
+    return type == Schema::Element::Int || type == Schema::Element::Integer
+            || type == Schema::Element::UnsignedLong || type == Schema::Element::Decimal;
+}
+
+QString ParserCreator::enumDefaultValue(const QString &className, const Schema::Attribute &a)
+{
+    const QStringList values = a.enumerationValues();
+    const QString value = values.contains(a.defaultValue()) ? a.defaultValue() : values.first();
+    return className + "::" + Creator::enumValue(Namer::getClassName(a.name()) + "Enum", value);
+}
+
+QString ParserCreator::numberReader(Schema::Node::Type type)
+{
+    QString name;
+    QString typeName;
+    QString converter;
+    if (type == Schema::Element::Int) {
+        name = "readInt32Element";
+        typeName = "qint32";
+        converter = "toInt";
+    } else if (type == Schema::Element::Integer) {
+        name = "readInt64Element";
+        typeName = "qlonglong";
+        converter = "toLongLong";
+    } else if (type == Schema::Element::UnsignedLong) {
+        name = "readUInt64Element";
+        typeName = "quint64";
+        converter = "toULongLong";
+    } else {
+        name = "readDecimalElement";
+        typeName = "double";
+        converter = "toDouble";
+    }
+
+    creator()->addParserHelper(createNumberReader(name, typeName, converter));
+
+    return name;
+}
+
+KODE::Code ParserCreator::createMappedFileParser(const QString &className)
+{
+    KODE::Code code;
+
+    // Files which are too large for parseBuffer() are read from the device
+    code += "const qint64 size = file.size();";
+    code += "uchar *data = size > 0 && size <= std::numeric_limits<int>::max() ? "
+            "file.map( 0, size ) : nullptr;";
+    code += "if ( data ) {";
+    code.indent();
+    code += className + " c = parseBuffer( reinterpret_cast<const char *>( data ), "
+                        "size_t( size ), ok );";
+    code += "file.unmap( data );";
+    code += "return c;";
+    code.unindent();
+    code += '}';
+
+    return code;
+}
+
+KODE::Code ParserCreator::createBufferSizeCheck(const QString &className)
+{
+    KODE::Code code;
+
+    code += "if ( size > size_t( std::numeric_limits<int>::max() ) ) {";
+    code += "  " + creator()->errorStream()
+            + " << \"Buffer of\" << size << \"bytes is too large\";";
+    code += "  if ( ok ) *ok = false;";
+    code += "  return " + className + "();";
+    code += '}';
+
+    return code;
+}
+
+bool ParserCreator::isCountedRelation(const Schema::Relation &r) const
+{
+    return creator()->validate() && r.choice().isEmpty()
+            && (r.minOccurs() > 0 || r.maxOccurs() != Schema::Relation::Unbounded);
+}
+
+QString ParserCreator::occurrenceCounter(const Schema::Relation &r)
+{
+    return KODE::Style::lowerFirst(Namer::getClassName(r.target())) + "Occurrences";
+}
+
+KODE::Code ParserCreator::createChildFailureCheck()
+{
+    KODE::Code code;
+
+    if (creator()->validate()) {
+        code += "if ( !ok ) valid = false;";
+    }
+
+    return code;
+}
+
+KODE::Code ParserCreator::createOccurrenceCounters(const Schema::Element &e)
+{
+    KODE::Code code;
+
+    QStringList counters;
+    const auto elementRelations = e.elementRelations();
+    for (const Schema::Relation &r : elementRelations) {
+        if (isCountedRelation(r) && !counters.contains(occurrenceCounter(r))) {
+            counters.append(occurrenceCounter(r));
+            code += "int " + occurrenceCounter(r) + " = 0;";
+        }
+    }
+
+    return code;
+}
+
+KODE::Code ParserCreator::createOccurrenceChecks(const Schema::Element &e, const QString &line,
+                                                 const QString &column)
+{
+    KODE::Code code;
+
+    const QString position = " at \" << " + line + " << \",\" << " + column;
+
+    QStringList counters;
+    const auto elementRelations = e.elementRelations();
+    for (const Schema::Relation &r : elementRelations) {
+        if (!isCountedRelation(r) || counters.contains(occurrenceCounter(r))) {
+            continue;
+        }
+        const QString counter = occurrenceCounter(r);
+        counters.append(counter);
+
+        if (r.minOccurs() > 0) {
+            code += "if ( " + counter + " < " + QString::number(r.minOccurs()) + " ) {";
+            code += "  " + creator()->errorStream() + " << \"Expected at least "
+                    + QString::number(r.minOccurs()) + " '" + r.target() + "' in '" + e.name()
+                    + "'" + position + " << \", got \" << " + counter + ";";
+            code += "  valid = false;";
+            code += '}';
+        }
+        if (r.maxOccurs() != Schema::Relation::Unbounded) {
+            code += "if ( " + counter + " > " + QString::number(r.maxOccurs()) + " ) {";
+            code += "  " + creator()->errorStream() + " << \"Expected at most "
+                    + QString::number(r.maxOccurs()) + " '" + r.target() + "' in '" + e.name()
+                    + "'" + position + " << \", got \" << " + counter + ";";
+            code += "  valid = false;";
+            code += '}';
+        }
+    }
+
+    return code;
+}
+
+KODE::Code ParserCreator::createValidityCheck(const QString &className)
+{
+    KODE::Code code;
+
+    code += "if ( !valid ) {";
+    code += "  if ( ok ) *ok = false;";
+    code += "  return " + className + "();";
+    code += '}';
+
+    return code;
+}
+
+static QString charLiteral(QChar c)
+{
+    if (c.isLetterOrNumber() && c.unicode() < 128) {
+        return QString("'") + c + '\'';
+    }
+    return QString::number(c.unicode());
+}
+
+KODE::Code ParserCreator::createTagDispatcher(const QString &name, const QStringList &tags,
+                                              const QList<KODE::Code> &branches,
+                                              const KODE::Code &fallback)
+{
+    KODE::Code code;
+
+    // Group the tags by length and first character. The first occurrence of a
+    // tag wins, as it would in an if/else chain. Lengths and characters are
+    // UTF-16 code units on both sides, so tags which aren't ASCII end up in
+    // the same bucket as the names read from the document.
+    QMap<int, QMap<ushort, QList<int>>> buckets;
+    QStringList seen;
+    for (int i = 0; i < tags.count(); ++i) {
+        const QString &tag = tags.at(i);
+        if (tag.isEmpty() || seen.contains(tag)) {
+            continue;
+        }
+        seen.append(tag);
+        buckets[tag.length()][tag.at(0).unicode()].append(i);
+    }
+
+    code += "int tag = -1;";
+    code += "switch ( " + name + ".size() ) {";
+    QMap<int, QMap<ushort, QList<int>>>::ConstIterator it;
+    for (it = buckets.constBegin(); it != buckets.constEnd(); ++it) {
+        code += "case " + QString::number(it.key()) + ':';
+        code.indent();
+        const QMap<ushort, QList<int>> &firstChars = it.value();
+        const bool switchFirstChar = firstChars.count() > 1;
+        if (switchFirstChar) {
+            code += "switch ( " + name + ".at( 0 ).unicode() ) {";
+        }
+        QMap<ushort, QList<int>>::ConstIterator it2;
+        for (it2 = firstChars.constBegin(); it2 != firstChars.constEnd(); ++it2) {
+            if (switchFirstChar) {
+                code += "case " + charLiteral(QChar(it2.key())) + ':';
+                code.indent();
+            }
+            const QList<int> &indices = it2.value();
+            for (int i = 0; i < indices.count(); ++i) {
+                const int index = indices.at(i);
+                code += QString(i > 0 ? "else " : "") + "if ( " + name
+                        + " == " + Creator::comparisonLiteral(tags.at(index)) + " ) tag = "
+                        + QString::number(index) + ';';
+            }
+            if (switchFirstChar) {
+                code += "break;";
+                code.unindent();
+            }
+        }
+        if (switchFirstChar) {
+            code += '}';
+        }
+        code += "break;";
+        code.unindent();
+    }
+    code += '}';
+    code.newLine();
+
+    code += "switch ( tag ) {";
+    for (int i = 0; i < branches.count(); ++i) {
+        if (!seen.contains(tags.value(i)) || tags.indexOf(tags.at(i)) != i) {
+            continue;
+        }
+        code += "case " + QString::number(i) + ": {";
+        code.indent();
+        code += branches.at(i);
+        code += "break;";
+        code.unindent();
+        code += '}';
+    }
+    if (!fallback.isEmpty()) {
+        code += "default:";
+        code.indent();
+        code += fallback;
+        code += "break;";
+        code.unindent();
+    }
+    code += '}';
+
+    return code;
+}
@@ -55,7 +55,12 @@ public:
         bool m_hasId;
     };
 
-    enum XmlParserType { XmlParserDom, XmlParserDomExternal };
+    enum XmlParserType {
+        XmlParserDom,
+        XmlParserDomExternal,
+        XmlParserStream,
+        XmlParserStreamExternal
+    };
 
     Creator(const Schema::Document &document, XmlParserType p = XmlParserDom);
 
@@ -66,6 +71,13 @@ public:
 
     void setCreateCrudFunctions(bool createCrud);
 
+    /**
+      Return true, if the class generated for @p element has an UpdatedAt CRUD
+      timestamp, which is set when it is read or committed. Parsers clear the
+      pending timestamps of the objects they create.
+    */
+    bool hasPendingTimestamps(const Schema::Element &element) const;
+
     /**
      * @brief setCreateWriterFunctions
      * This method can be used to enable/disable the generation of the XML
@@ -82,6 +94,138 @@ public:
      */
     void setCreateParserFunctions(bool createParser = true);
 
+    /**
+     * @brief setCreateVisitor
+     * This method can be used to enable the generation of a visitor interface
+     * for the start element. The visitor receives the items of the list
+     * relations of the start element one by one while they are parsed, so
+     * they don't have to be kept in memory. Requires the stream parser.
+     * @param createVisitor
+     */
+    void setCreateVisitor(bool createVisitor);
+    bool createVisitor() const;
+
+    QString visitorClassName() const;
+
+    /**
+     * @brief setCreateArena
+     * This method can be used to enable the generation of an arena allocator
+     * for the classes and of a document class owning the arena and the
+     * parsed start element. Objects created by the containers of the
+     * generated classes while the arena is current are allocated in bulk
+     * from the arena and released together with it.
+     * @param createArena
+     */
+    void setCreateArena(bool createArena);
+    bool createArena() const;
+
+    /**
+     * @brief setUseSharedData
+     * This method can be used to make the generated classes implicitly
+     * shared. Their members are kept in a private class derived from
+     * QSharedData, so copies are cheap and detach on the first write.
+     * @param useSharedData
+     */
+    void setUseSharedData(bool useSharedData);
+    bool useSharedData() const;
+
+    /**
+     * @brief setParallelParse
+     * This method can be used to make the generated DOM parsers parse the
+     * items of elements which only contain lists in parallel with
+     * QtConcurrent, if there are many of them.
+     * @param parallelParse
+     */
+    void setParallelParse(bool parallelParse);
+    bool parallelParse() const;
+
+    /**
+     * @brief setParallelWrite
+     * This method can be used to make the generated writers serialize long
+     * lists of elements which only contain lists in parallel with
+     * QtConcurrent. This is only done when writing without auto formatting
+     * to a device in UTF-8.
+     * @param parallelWrite
+     */
+    void setParallelWrite(bool parallelWrite);
+    bool parallelWrite() const;
+
+    /**
+     * @brief setLazyParse
+     * This method can be used to make the generated DOM parsers keep the
+     * elements of complex children instead of parsing them. A child is
+     * parsed when it is accessed for the first time. This only saves CPU
+     * time: the document is still read into a QDomDocument, and a kept
+     * element holds on to the whole document, not only to its own subtree.
+     * @param lazyParse
+     */
+    void setLazyParse(bool lazyParse);
+    bool lazyParse() const;
+
+    /**
+     * @brief setIncremental
+     * This method can be used to enable the generation of an update()
+     * function for the start element, which parses a new version of the
+     * document and takes over the unchanged items of the lists of the start
+     * element from the previous version. Requires the stream parser.
+     * @param incremental
+     */
+    void setIncremental(bool incremental);
+    bool incremental() const;
+
+    /**
+     * @brief setCreateBinaryFunctions
+     * This method can be used to enable the generation of functions writing
+     * the generated classes to a QDataStream and reading them from it.
+     * @param createBinaryFunctions
+     */
+    void setCreateBinaryFunctions(bool createBinaryFunctions);
+    bool createBinaryFunctions() const;
+
+    /**
+     * @brief setCreateJsonFunctions
+     * This method can be used to enable the generation of functions
+     * converting the generated classes to JSON and back.
+     * @param createJsonFunctions
+     */
+    void setCreateJsonFunctions(bool createJsonFunctions);
+    bool createJsonFunctions() const;
+
+    /**
+     * @brief setValidate
+     * This method can be used to make the generated parsers check the
+     * number of occurrences of child elements and the presence of required
+     * attributes while parsing. Violations are reported with their position
+     * and make parsing fail.
+     * @param validate
+     */
+    void setValidate(bool validate);
+    bool validate() const;
+
+    /**
+      Return the name of the function parsing the pending elements of the
+      lazily parsed property @p name.
+    */
+    static QString materializer(const QString &name);
+
+    /**
+      Return the name of the constant for @p value in the enum @p enumName.
+      KODE::Enum prefixes the values with the name of the enum.
+    */
+    static QString enumValue(const QString &enumName, const QString &value);
+
+    /**
+      Return the expression accessing the member variable @p member from a
+      member function of a generated class.
+    */
+    QString memberAccess(const QString &member) const;
+
+    /**
+      Like memberAccess(), but the expression doesn't detach shared data, so
+      it can be used for reading in non-const member functions.
+    */
+    QString constMemberAccess(const QString &member) const;
+
     void setLicense(const KODE::License &);
 
     void setExportDeclaration(const QString &name);
@@ -97,13 +241,43 @@ public:
     void setParserClass(const KODE::Class &);
     KODE::Class &parserClass();
 
+    /**
+      Add a static helper function to the implementation file holding the
+      parser code. Functions with the name of an already added helper are
+      ignored.
+    */
+    void addParserHelper(const KODE::Function &function);
+
     const Schema::Document &document() const;
 
     void create();
 
-    void createCrudFunctions(KODE::Class &c, const QString &type);
+    void createCrudFunctions(KODE::Class &c, KODE::Code &constructorCode, const QString &type,
+                             bool targetHasUpdatedTimestamp = false,
+                             const QString &hashesMember = QString(),
+                             const QString &timestampUpdate = QString());
+    void createTimestampFunctions(KODE::Class &c, KODE::Code &constructorCode,
+                                  bool hasCreatedAt, bool hasUpdatedAt);
+    void createBatchCrudFunctions(KODE::Class &c, const QString &type,
+                                  bool targetHasUpdatedTimestamp, const QString &discardHashes,
+                                  const QString &timestampUpdate);
+
+    /**
+      Create the static functions converting between the enum generated for
+      the enumeration attribute @p a and the names used in XML. Names are
+      looked up by binary search in a sorted table of names and enum
+      constants, enum values are converted to names by a switch returning
+      shared strings.
+    */
+    void createEnumConverters(KODE::Class &c, const Schema::Attribute &a);
     void createProperty(KODE::Class &c, const ClassDescription &, const QString &type,
-                        const QString &name);
+                        const QString &name, bool lazy = false,
+                        const QString &indexMember = QString(),
+                        const QString &hashesMember = QString());
+    void createMaterializer(KODE::Class &c, const QString &type, const QString &name,
+                            const QString &pendingMember);
+
+    void createBinaryFunctions(KODE::Class &c, const ClassDescription &description);
 
     ClassDescription createClassDescription(const Schema::Element &element);
     void createClass(const Schema::Element &element);
@@ -118,11 +292,30 @@ public:
 
     void createFileWriter(const Schema::Element &element);
 
+    void createVisitorClass(const Schema::Element &element);
+
+    void createArenaClasses(const Schema::Element &element);
+    void createArenaAllocator(KODE::Class &c);
+
     void printFiles(KODE::Printer &);
 
     QString errorStream() const;
     QString debugStream() const;
 
+    /**
+      Return a QStringLiteral expression for @p text. The string data is
+      created at compile time, so passing it to functions taking a QString
+      doesn't convert or allocate at runtime.
+    */
+    static QString stringLiteral(const QString &text);
+
+    /**
+      Return a string literal for comparing with @p text. ASCII text becomes
+      a QLatin1String, which compares without allocating. Other text becomes
+      a QStringLiteral, because the generated source code is UTF-8 encoded.
+    */
+    static QString comparisonLiteral(const QString &text);
+
     void setUseQEnums(bool useQEnums);
     bool useQEnums() const;
 
@@ -142,6 +335,7 @@ private:
     KODE::File mFile;
     KODE::Class mParserClass;
     KODE::Class mWriterClass;
+    QList<KODE::Function> mParserHelpers;
     QStringList mProcessedClasses;
     QStringList mListTypedefs;
 
@@ -149,10 +343,20 @@ private:
     QString mDtd;
     bool mVerbose;
     bool mUseKde;
-    bool mCreateCrudFunctions;
+    bool mCreateCrudFunctions = false;
     bool mUseQEnums = false;
     bool mCreateWriterFunctions = true;
     bool mCreateParserFunctions = true;
+    bool mCreateVisitor = false;
+    bool mCreateArena = false;
+    bool mUseSharedData = false;
+    bool mParallelParse = false;
+    bool mParallelWrite = false;
+    bool mLazyParse = false;
+    bool mIncremental = false;
+    bool mCreateBinaryFunctions = false;
+    bool mCreateJsonFunctions = false;
+    bool mValidate = false;
     QString mExportDeclaration;
 };
 
@@ -167,6 +371,99 @@ public:
     virtual void createFileParser(const Schema::Element &element) = 0;
     virtual void createStringParser(const Schema::Element &element) = 0;
     virtual void createElementParser(KODE::Class &c, const Schema::Element &e) = 0;
+    virtual void createBufferParser(const Schema::Element &element) = 0;
+
+protected:
+    QString stringToDataConverter(const QString &data, Schema::Node::Type);
+
+    /**
+      Return true if element text of @p type is converted by a number reader
+      instead of stringToDataConverter().
+    */
+    static bool isNumberType(Schema::Node::Type type);
+
+    /**
+      Return an expression holding the default value of the enum generated in
+      class @p className for the enumeration attribute @p a.
+    */
+    static QString enumDefaultValue(const QString &className, const Schema::Attribute &a);
+
+    /**
+      Return the name of the generated helper function reading the text of an
+      element as number of @p type. The helper is created on first use.
+    */
+    QString numberReader(Schema::Node::Type type);
+
+    /**
+      Create the helper function @p name, which reads the text of an element
+      and converts it to @p typeName by calling @p converter on a QString or
+      QStringRef. Invalid numbers are reported with their line number.
+    */
+    virtual KODE::Function createNumberReader(const QString &name, const QString &typeName,
+                                              const QString &converter) = 0;
+
+    /**
+      Create code which memory maps the opened QFile "file" and hands it to
+      parseBuffer(). If the file can't be mapped or is too large for
+      parseBuffer(), execution continues after the code, so a parser reading
+      from the device can follow as fallback.
+    */
+    KODE::Code createMappedFileParser(const QString &className);
+
+    /**
+      Create code rejecting buffers which don't fit into a QByteArray.
+    */
+    KODE::Code createBufferSizeCheck(const QString &className);
+
+    /**
+      Return true, if the occurrences of the element relation @p r are
+      counted for validation. Relations which are part of a choice are not
+      counted.
+    */
+    bool isCountedRelation(const Schema::Relation &r) const;
+
+    /**
+      Return the name of the variable counting the occurrences of @p r.
+    */
+    static QString occurrenceCounter(const Schema::Relation &r);
+
+    /**
+      Return the code reporting a child which couldn't be parsed as
+      violation, if the parser validates. Otherwise the child is skipped.
+    */
+    KODE::Code createChildFailureCheck();
+
+    /**
+      Create the declarations of the occurrence counters of element @p e.
+    */
+    KODE::Code createOccurrenceCounters(const Schema::Element &e);
+
+    /**
+      Create code comparing the occurrence counters of element @p e with the
+      limits of the relations. Violations are reported at the position
+      @p line, @p column and reset the variable "valid".
+    */
+    KODE::Code createOccurrenceChecks(const Schema::Element &e, const QString &line,
+                                      const QString &column);
+
+    /**
+      Create code returning an invalid object of class @p className, if the
+      variable "valid" has been reset.
+    */
+    KODE::Code createValidityCheck(const QString &className);
+
+    /**
+      Create code which dispatches on the tag name held in the variable
+      @p name, which has to provide size(), at() and comparison with
+      QLatin1String. The branch with the same index as the matching entry in
+      @p tags is executed, @p fallback is executed for unknown tags. The
+      dispatch is a switch over length and first character of the name, so
+      the costs don't depend on the number of tags and no temporary strings
+      are created.
+    */
+    KODE::Code createTagDispatcher(const QString &name, const QStringList &tags,
+                                   const QList<KODE::Code> &branches,
+                                   const KODE::Code &fallback = KODE::Code());
 
 private:
     Creator *mCreator;
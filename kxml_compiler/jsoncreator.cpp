@@ -0,0 +1,292 @@
+/*
+    This file is part of KDE.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+    USA.
+*/
+
+#include "jsoncreator.h"
+
+#include "creator.h"
+
+#include "namer.h"
+#include "style.h"
+
+JsonCreator::JsonCreator(KODE::File &file, const Schema::Document &document)
+    : mFile(file), mDocument(document)
+{
+}
+
+void JsonCreator::createJsonFunctions(KODE::Class &c, const Schema::Element &element)
+{
+    c.addHeaderInclude("QJsonObject");
+    c.addInclude("QJsonArray");
+    c.addInclude("QJsonValue");
+
+    KODE::Function writer("toJson", "QJsonObject");
+    writer.setConst(true);
+    writer.setDocs("Convert object to a JSON object with the same structure as the XML element.");
+
+    KODE::Function reader("fromJson", c.name());
+    reader.setStatic(true);
+    reader.setDocs("Create object from a JSON object created by toJson().");
+    reader.addArgument("const QJsonObject &object");
+    reader.addArgument(KODE::Function::Argument("bool *ok", "nullptr"));
+
+    KODE::Code writeCode;
+    KODE::Code readCode;
+
+    writeCode += "QJsonObject object;";
+    readCode += c.name() + " result = " + c.name() + "();";
+
+    writeCode += createAttributeWriter(element);
+    readCode += createAttributeReader(c.name(), element);
+
+    if (element.text()) {
+        writeCode += "object.insert( " + Creator::stringLiteral("value") + ", "
+                + dataToJsonConverter("value()", element.type()) + " );";
+        readCode += "result.setValue( "
+                + jsonToDataConverter("object.value( " + Creator::stringLiteral("value") + " )",
+                                      element.type())
+                + " );";
+    } else {
+        const auto elementRelations = element.elementRelations();
+        for (const Schema::Relation &r : elementRelations) {
+            const QString type = Namer::getClassName(r.target());
+            const QString key = Creator::stringLiteral(r.target());
+            const QString value = "object.value( " + key + " )";
+
+            if (r.isList()) {
+                writeCode += '{';
+                writeCode.indent();
+                writeCode += "QJsonArray array;";
+                writeCode += "for ( const " + type + " &e : " + Namer::getListAccessor(r.target())
+                        + "() ) {";
+                writeCode += "  array.append( e.toJson() );";
+                writeCode += '}';
+                writeCode += "object.insert( " + key + ", array );";
+                writeCode.unindent();
+                writeCode += '}';
+
+                readCode += '{';
+                readCode.indent();
+                readCode += "const QJsonArray array = " + value + ".toArray();";
+                readCode += "result.reserve" + type + "List( array.size() );";
+                readCode += "for ( const QJsonValue &item : array ) {";
+                readCode.indent();
+                readCode += "bool itemOk;";
+                readCode += type + " o = " + type + "::fromJson( item.toObject(), &itemOk );";
+                readCode += "if ( !itemOk ) {";
+                readCode += "  if ( ok ) *ok = false;";
+                readCode += "  return " + c.name() + "();";
+                readCode += '}';
+                readCode += "result.add" + type + "( std::move( o ) );";
+                readCode.unindent();
+                readCode += '}';
+                readCode.unindent();
+                readCode += '}';
+                continue;
+            }
+
+            const Schema::Element &e = mDocument.element(r);
+            if (e.text() && !e.hasAttributeRelations()) {
+                // Flattened elements are stored as strings, unless they are
+                // numbers, booleans or dates
+                Schema::Node::Type leafType = e.type();
+                if (leafType == Schema::Element::DateTime) {
+                    leafType = Schema::Element::String;
+                }
+                writeCode += "object.insert( " + key + ", "
+                        + dataToJsonConverter(Namer::getAccessor(e.name()) + "()", leafType)
+                        + " );";
+                readCode += "if ( object.contains( " + key + " ) ) {";
+                readCode += "  result.set" + type + "( " + jsonToDataConverter(value, leafType)
+                        + " );";
+                readCode += '}';
+            } else {
+                writeCode += "object.insert( " + key + ", " + Namer::getAccessor(r.target())
+                        + "().toJson() );";
+
+                readCode += "if ( object.contains( " + key + " ) ) {";
+                readCode.indent();
+                readCode += "bool childOk;";
+                readCode += type + " o = " + type + "::fromJson( " + value
+                        + ".toObject(), &childOk );";
+                readCode += "if ( !childOk ) {";
+                readCode += "  if ( ok ) *ok = false;";
+                readCode += "  return " + c.name() + "();";
+                readCode += '}';
+                readCode += "result.set" + type + "( std::move( o ) );";
+                readCode.unindent();
+                readCode += '}';
+            }
+        }
+    }
+
+    writeCode += "return object;";
+
+    if (mClearPendingTimestamps) {
+        readCode += "result.clearPendingTimestamps();";
+    }
+    readCode += "if ( ok ) *ok = true;";
+    readCode += "return result;";
+
+    writer.setBody(writeCode);
+    reader.setBody(readCode);
+
+    c.addInclude("utility");
+
+    c.addFunction(writer);
+    c.addFunction(reader);
+}
+
+void JsonCreator::createDocumentFunctions(const QString &className, const QString &errorStream)
+{
+    KODE::Class c = mFile.findClass(className);
+
+    c.addHeaderInclude("QByteArray");
+    c.addHeaderInclude("QJsonDocument");
+    c.addInclude("QtDebug");
+
+    KODE::Function writer("writeJson", "QByteArray");
+    writer.setConst(true);
+    writer.setDocs("Write object as JSON document.");
+    writer.addArgument(KODE::Function::Argument(
+            "QJsonDocument::JsonFormat format", "QJsonDocument::Indented"));
+    writer.addBodyLine("return QJsonDocument( toJson() ).toJson( format );");
+
+    c.addFunction(writer);
+
+    KODE::Function parser("parseJson", className);
+    parser.setStatic(true);
+    parser.setDocs("Parse JSON document written by writeJson().");
+    parser.addArgument("const QByteArray &data");
+    parser.addArgument("bool *ok");
+
+    KODE::Code code;
+
+    code += "QJsonParseError error;";
+    code += "const QJsonDocument document = QJsonDocument::fromJson( data, &error );";
+    code += "if ( !document.isObject() ) {";
+    code += "  " + errorStream + " << error.errorString() << \" at \" << error.offset;";
+    code += "  if ( ok ) *ok = false;";
+    code += "  return " + className + "();";
+    code += '}';
+    code += "return fromJson( document.object(), ok );";
+
+    parser.setBody(code);
+
+    c.addFunction(parser);
+
+    mFile.insertClass(c);
+}
+
+void JsonCreator::setClearPendingTimestamps(bool clearPendingTimestamps)
+{
+    mClearPendingTimestamps = clearPendingTimestamps;
+}
+
+QString JsonCreator::dataToJsonConverter(const QString &data, Schema::Node::Type type)
+{
+    // 64 bit integers are stored as strings, JSON numbers are doubles
+    if (type == Schema::Element::Int || type == Schema::Element::Decimal
+        || type == Schema::Element::Boolean) {
+        return "QJsonValue( " + data + " )";
+    } else if (type == Schema::Element::Integer || type == Schema::Element::UnsignedLong) {
+        return "QString::number( " + data + " )";
+    } else if (type == Schema::Element::Date || type == Schema::Element::DateTime) {
+        return data + ".toString( Qt::ISODate )";
+    } else {
+        return data;
+    }
+}
+
+QString JsonCreator::jsonToDataConverter(const QString &value, Schema::Node::Type type)
+{
+    if (type == Schema::Element::Int) {
+        return value + ".toInt()";
+    } else if (type == Schema::Element::Decimal) {
+        return value + ".toDouble()";
+    } else if (type == Schema::Element::Boolean) {
+        return value + ".toBool()";
+    } else if (type == Schema::Element::Integer) {
+        return value + ".toString().toLongLong()";
+    } else if (type == Schema::Element::UnsignedLong) {
+        return value + ".toString().toULongLong()";
+    } else if (type == Schema::Element::Date) {
+        return "QDate::fromString( " + value + ".toString(), Qt::ISODate )";
+    } else if (type == Schema::Element::DateTime) {
+        return "QDateTime::fromString( " + value + ".toString(), Qt::ISODate )";
+    } else {
+        return value + ".toString()";
+    }
+}
+
+KODE::Code JsonCreator::createAttributeWriter(const Schema::Element &element)
+{
+    KODE::Code code;
+
+    const auto attributeRelations = element.attributeRelations();
+    for (const Schema::Relation &r : attributeRelations) {
+        const Schema::Attribute &a = mDocument.attribute(r, element.name());
+
+        QString data = Namer::getAccessor(a.name()) + "()";
+        if (a.enumerationValues().count()) {
+            data = KODE::Style::lowerFirst(Namer::getClassName(a.name())) + "EnumToName( " + data
+                    + " )";
+        } else {
+            data = dataToJsonConverter(data, a.type());
+        }
+        code += "object.insert( " + Creator::stringLiteral(a.name()) + ", " + data + " );";
+    }
+
+    return code;
+}
+
+KODE::Code JsonCreator::createAttributeReader(const QString &className,
+                                              const Schema::Element &element)
+{
+    KODE::Code code;
+
+    const auto attributeRelations = element.attributeRelations();
+    for (const Schema::Relation &r : attributeRelations) {
+        const Schema::Attribute &a = mDocument.attribute(r, element.name());
+
+        const QString name = Namer::getClassName(a.name());
+        const QString key = Creator::stringLiteral(a.name());
+        const QString value = "object.value( " + key + " )";
+
+        if (a.enumerationValues().count()) {
+            // Missing values get the default of the XML parsers
+            code += "result.set" + name + "( "
+                    + ParserCreator::enumDefaultValue(className, a) + " );";
+            code += "if ( object.contains( " + key + " ) ) {";
+            code.indent();
+            code += "bool valueOk;";
+            code += "result.set" + name + "( " + KODE::Style::lowerFirst(name) + "EnumFromName( "
+                    + value + ".toString(), &valueOk ) );";
+            code += "if ( !valueOk ) {";
+            code += "  if ( ok ) *ok = false;";
+            code += "  return " + className + "();";
+            code += '}';
+            code.unindent();
+            code += '}';
+        } else {
+            code += "result.set" + name + "( " + jsonToDataConverter(value, a.type()) + " );";
+        }
+    }
+
+    return code;
+}
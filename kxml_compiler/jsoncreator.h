@@ -0,0 +1,60 @@
+/*
+    This file is part of KDE.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+    USA.
+*/
+#ifndef JSONCREATOR_H
+#define JSONCREATOR_H
+
+#include "schema.h"
+
+#include <file.h>
+
+/**
+  Creates functions converting the generated classes to JSON objects and
+  back. The JSON objects mirror the XML: attributes and child elements are
+  stored under their XML names, lists as arrays and the text of elements
+  as "value".
+*/
+class JsonCreator
+{
+public:
+    JsonCreator(KODE::File &, const Schema::Document &document);
+
+    void createJsonFunctions(KODE::Class &c, const Schema::Element &e);
+
+    void createDocumentFunctions(const QString &className, const QString &errorStream);
+
+    /**
+      Make the created objects keep the timestamps of the JSON object, like
+      the parsed objects do.
+    */
+    void setClearPendingTimestamps(bool clearPendingTimestamps);
+
+protected:
+    QString dataToJsonConverter(const QString &data, Schema::Node::Type);
+    QString jsonToDataConverter(const QString &value, Schema::Node::Type);
+
+    KODE::Code createAttributeWriter(const Schema::Element &element);
+    KODE::Code createAttributeReader(const QString &className, const Schema::Element &element);
+
+private:
+    KODE::File &mFile;
+    const Schema::Document &mDocument;
+    bool mClearPendingTimestamps = false;
+};
+
+#endif
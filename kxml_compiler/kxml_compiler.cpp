@@ -76,6 +76,14 @@ int main(int argc, char **argv)
             QCoreApplication::translate("main", "Generate parser in separate source file"));
     cmdLine.addOption(extParserOption);
 
+    QCommandLineOption parserOption(
+            "parser",
+            QCoreApplication::translate("main",
+                                        "Parser backend of the generated code. Possible values: "
+                                        "dom (default), stream"),
+            "parser", "dom");
+    cmdLine.addOption(parserOption);
+
     QCommandLineOption xsdOption("xsd",
                                  QCoreApplication::translate("main", "Schema is XML Schema"));
     cmdLine.addOption(xsdOption);
@@ -115,6 +123,86 @@ int main(int argc, char **argv)
                     "main", "Create functions for dealing with data suitable for CRUD model"));
     cmdLine.addOption(createCRUDFunctionsOption);
 
+    QCommandLineOption createVisitorOption(
+            "create-visitor",
+            QCoreApplication::translate(
+                    "main",
+                    "Create a visitor interface which receives the list items of the top-level "
+                    "element one by one while parsing (requires --parser stream)"));
+    cmdLine.addOption(createVisitorOption);
+
+    QCommandLineOption arenaOption(
+            "arena",
+            QCoreApplication::translate(
+                    "main",
+                    "Allocate the list items of a parsed document in bulk from an arena owned by a "
+                    "generated document class. Strings and shared private data stay on the heap "
+                    "(not available with --external-parser)"));
+    cmdLine.addOption(arenaOption);
+
+    QCommandLineOption sharedDataOption(
+            "shared-data",
+            QCoreApplication::translate("main",
+                                        "Make the generated classes implicitly shared, so copying "
+                                        "them doesn't copy their members"));
+    cmdLine.addOption(sharedDataOption);
+
+    QCommandLineOption parallelParseOption(
+            "parallel-parse",
+            QCoreApplication::translate(
+                    "main",
+                    "Parse the items of elements which only contain lists in parallel, if there "
+                    "are many of them (requires --parser dom, the generated code needs "
+                    "Qt5::Concurrent)"));
+    cmdLine.addOption(parallelParseOption);
+
+    QCommandLineOption parallelWriteOption(
+            "parallel-write",
+            QCoreApplication::translate(
+                    "main",
+                    "Write long lists of elements which only contain lists in parallel, when "
+                    "writing without auto formatting (the generated code needs Qt5::Concurrent)"));
+    cmdLine.addOption(parallelWriteOption);
+
+    QCommandLineOption lazyOption(
+            "lazy",
+            QCoreApplication::translate(
+                    "main",
+                    "Parse complex children when they are accessed first. This saves the CPU "
+                    "time of parsing children which are never read, but the whole DOM document "
+                    "is still built and stays in memory as long as an unparsed child refers to "
+                    "it (requires --parser dom)"));
+    cmdLine.addOption(lazyOption);
+
+    QCommandLineOption incrementalOption(
+            "incremental",
+            QCoreApplication::translate(
+                    "main",
+                    "Generate an update() function which reparses only the changed items of the "
+                    "lists of the start element (requires --parser stream)"));
+    cmdLine.addOption(incrementalOption);
+
+    QCommandLineOption createBinaryFunctionsOption(
+            "create-binary-functions",
+            QCoreApplication::translate("main",
+                                        "Create functions writing the classes to a QDataStream "
+                                        "and reading them from it"));
+    cmdLine.addOption(createBinaryFunctionsOption);
+
+    QCommandLineOption createJsonFunctionsOption(
+            "create-json-functions",
+            QCoreApplication::translate("main",
+                                        "Create functions converting the classes to JSON and "
+                                        "back"));
+    cmdLine.addOption(createJsonFunctionsOption);
+
+    QCommandLineOption validateOption(
+            "validate",
+            QCoreApplication::translate("main",
+                                        "Check occurrences of elements and required attributes "
+                                        "while parsing"));
+    cmdLine.addOption(validateOption);
+
     QCommandLineOption outputFileName(
             "output-filename",
             QCoreApplication::translate("main",
@@ -166,6 +254,47 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    const QString parserType = cmdLine.value(parserOption);
+    if (parserType != "dom" && parserType != "stream") {
+        qCritical().noquote() << QCoreApplication::translate("main", "Unknown parser backend '%1'")
+                                         .arg(parserType);
+        return -1;
+    }
+
+    if (cmdLine.isSet(createVisitorOption) && parserType != "stream") {
+        qCritical().noquote() << QCoreApplication::translate(
+                "main", "The create-visitor option requires the stream parser");
+        return -1;
+    }
+
+    if (cmdLine.isSet(parallelParseOption) && parserType != "dom") {
+        qCritical().noquote() << QCoreApplication::translate(
+                "main", "The parallel-parse option requires the DOM parser");
+        return -1;
+    }
+
+    if (cmdLine.isSet(lazyOption)
+        && (parserType != "dom" || cmdLine.isSet(extParserOption))) {
+        qCritical().noquote() << QCoreApplication::translate(
+                "main", "The lazy option requires the DOM parser and can't be combined with the "
+                        "external-parser option");
+        return -1;
+    }
+
+    if (cmdLine.isSet(incrementalOption)
+        && (parserType != "stream" || cmdLine.isSet(extParserOption))) {
+        qCritical().noquote() << QCoreApplication::translate(
+                "main", "The incremental option requires the stream parser and can't be combined "
+                        "with the external-parser option");
+        return -1;
+    }
+
+    if (cmdLine.isSet(arenaOption) && cmdLine.isSet(extParserOption)) {
+        qCritical().noquote() << QCoreApplication::translate(
+                "main", "The arena option can't be combined with the external-parser option");
+        return -1;
+    }
+
     if (cmdLine.positionalArguments().count() < 1) {
         qCritical().noquote() << QCoreApplication::translate("main", "No filename argument passed");
         return -1;
@@ -258,10 +387,18 @@ int main(int argc, char **argv)
     }
 
     Creator::XmlParserType pt;
-    if (cmdLine.isSet("external-parser")) {
-        pt = Creator::XmlParserDomExternal;
+    if (parserType == "stream") {
+        if (cmdLine.isSet("external-parser")) {
+            pt = Creator::XmlParserStreamExternal;
+        } else {
+            pt = Creator::XmlParserStream;
+        }
     } else {
-        pt = Creator::XmlParserDom;
+        if (cmdLine.isSet("external-parser")) {
+            pt = Creator::XmlParserDomExternal;
+        } else {
+            pt = Creator::XmlParserDom;
+        }
     }
 
     Creator c(schemaDocument, pt);
@@ -269,6 +406,16 @@ int main(int argc, char **argv)
     c.setUseKde(cmdLine.isSet("use-kde"));
     c.setCreateCrudFunctions(cmdLine.isSet("create-crud-functions"));
     c.setUseQEnums(cmdLine.isSet("generate-qenums"));
+    c.setCreateVisitor(cmdLine.isSet(createVisitorOption));
+    c.setCreateArena(cmdLine.isSet(arenaOption));
+    c.setUseSharedData(cmdLine.isSet(sharedDataOption));
+    c.setParallelParse(cmdLine.isSet(parallelParseOption));
+    c.setParallelWrite(cmdLine.isSet(parallelWriteOption));
+    c.setLazyParse(cmdLine.isSet(lazyOption));
+    c.setIncremental(cmdLine.isSet(incrementalOption));
+    c.setCreateBinaryFunctions(cmdLine.isSet(createBinaryFunctionsOption));
+    c.setCreateJsonFunctions(cmdLine.isSet(createJsonFunctionsOption));
+    c.setValidate(cmdLine.isSet(validateOption));
     c.setCreateParserFunctions(!cmdLine.isSet(dontCreateParseFunctionsOption));
     c.setCreateWriterFunctions(!cmdLine.isSet(dontCreateWriteFunctionsOption));
     if (cmdLine.isSet("namespace")) {
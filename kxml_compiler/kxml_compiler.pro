@@ -29,21 +29,25 @@ include(../libkode/libkode.pri)
 
 HEADERS += \
     writercreator.h \
+    jsoncreator.h \
     schema.h \
     parserxsd.h \
     parserxml.h \
     parserrelaxng.h \
     parsercreatordom.h \
+    parsercreatorstream.h \
     creator.h \
     classdescription.h
 
 SOURCES += \
     writercreator.cpp \
+    jsoncreator.cpp \
     schema.cpp \
     parserxsd.cpp \
     parserxml.cpp \
     parserrelaxng.cpp \
     parsercreatordom.cpp \
+    parsercreatorstream.cpp \
     kxml_compiler.cpp \
     creator.cpp \
     classdescription.cpp
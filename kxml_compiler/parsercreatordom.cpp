@@ -61,7 +61,7 @@ void ParserCreatorDom::createElementParser(KODE::Class &c, const Schema::Element
 
     KODE::Code code;
 
-    code += "if ( element.tagName() != \"" + e.name() + "\" ) {";
+    code += "if ( element.tagName() != " + Creator::comparisonLiteral(e.name()) + " ) {";
     code.indent();
     code += creator()->errorStream() + " << \"Expected '" + e.name()
             + "', got '\" << element.tagName() << \"'.\";";
@@ -72,35 +72,72 @@ void ParserCreatorDom::createElementParser(KODE::Class &c, const Schema::Element
     code.newLine();
 
     code += c.name() + " result = " + c.name() + "();";
+    if (creator()->validate()) {
+        code += "bool valid = true;";
+    }
     code.newLine();
 
+    // Items of pure lists are collected first and parsed in parallel
+    // afterwards, if there are enough of them.
+    const bool parallel = creator()->parallelParse() && !creator()->lazyParse() && e.isPureList();
+    QStringList parallelLists;
+
     if (e.hasElementRelations()) {
+        if (parallel) {
+            const auto elementRelations = e.elementRelations();
+            for (const Schema::Relation &r : elementRelations) {
+                QString className = Namer::getClassName(r.target());
+                if (!parallelLists.contains(className)) {
+                    parallelLists.append(className);
+                    code += "QVector<QDomElement> " + KODE::Style::lowerFirst(className)
+                            + "Elements;";
+                }
+            }
+        }
+        code += createOccurrenceCounters(e);
         code += "QDomNode n;";
         code += "for( n = element.firstChild(); !n.isNull();"
                 " n = n.nextSibling() ) {";
         code.indent();
         code += "QDomElement e = n.toElement();";
+        code += "if ( e.isNull() ) {";
+        code += "  continue;";
+        code += "}";
+        code += "const QString tagName = e.tagName();";
 
-        Schema::Relation::List elementRelations = e.elementRelations();
-        Schema::Relation::List::ConstIterator it;
-        for (it = elementRelations.constBegin(); it != elementRelations.constEnd(); ++it) {
-            QString condition;
-            if (it != elementRelations.constBegin())
-                condition = "else ";
-            condition += "if";
+        QStringList tags;
+        QList<KODE::Code> branches;
 
-            code += condition + " ( e.tagName() == \"" + (*it).target() + "\" ) {";
-            code.indent();
+        const auto elementRelations = e.elementRelations();
+        for (const Schema::Relation &r : elementRelations) {
+            KODE::Code branch;
 
-            QString className = Namer::getClassName((*it).target());
+            QString className = Namer::getClassName(r.target());
 
-            Schema::Element targetElement = creator()->document().element((*it).target());
+            const Schema::Element &targetElement = creator()->document().element(r.target());
 
-            if (targetElement.text() && !targetElement.hasAttributeRelations() && !(*it).isList()) {
-                QString data = stringToDataConverter("e.text()", targetElement.type());
-                code += "result.set" + className + "( " + data + " );";
+            if (parallel) {
+                branch += KODE::Style::lowerFirst(className) + "Elements.append( e );";
+            } else if (targetElement.text() && !targetElement.hasAttributeRelations()
+                       && !r.isList()) {
+                QString data;
+                if (isNumberType(targetElement.type())) {
+                    data = numberReader(targetElement.type()) + "( e )";
+                } else {
+                    data = stringToDataConverter("e.text()", targetElement.type());
+                }
+                branch += "result.set" + className + "( " + data + " );";
+            } else if (creator()->lazyParse()) {
+                // Complex children are parsed when they are accessed first
+                if (r.isList()) {
+                    branch += "result." + creator()->memberAccess("m" + className + "ListElements")
+                              + ".append( e );";
+                } else {
+                    branch += "result." + creator()->memberAccess("m" + className + "Element")
+                              + " = e;";
+                }
             } else {
-                code += "bool ok;";
+                branch += "bool ok;";
                 QString line = className + " o = ";
                 if (creator()->externalParser()) {
                     line += "parseElement" + className;
@@ -108,46 +145,87 @@ void ParserCreatorDom::createElementParser(KODE::Class &c, const Schema::Element
                     line += className + "::parseElement";
                 }
                 line += "( e, &ok );";
-                code += line;
+                branch += line;
 
-                if ((*it).isList()) {
-                    code += "if ( ok ) result.add" + className + "( o );";
+                if (r.isList()) {
+                    branch += "if ( ok ) result.add" + className + "( std::move( o ) );";
                 } else {
-                    code += "if ( ok ) result.set" + className + "( o );";
+                    branch += "if ( ok ) result.set" + className + "( std::move( o ) );";
                 }
+                branch += createChildFailureCheck();
             }
 
-            code.unindent();
-            code += '}';
+            if (isCountedRelation(r)) {
+                KODE::Code countedBranch;
+                countedBranch += "++" + occurrenceCounter(r) + ';';
+                countedBranch += branch;
+                branch = countedBranch;
+            }
+
+            tags.append(r.target());
+            branches.append(branch);
         }
 
+        code += createTagDispatcher("tagName", tags, branches);
+
         code.unindent();
         code += '}';
         code.newLine();
+
+        for (const QString &className : qAsConst(parallelLists)) {
+            code += createParallelListParser(className);
+            code.newLine();
+        }
+
+        code += createOccurrenceChecks(e, "element.lineNumber()", "element.columnNumber()");
     }
 
-    if (e.text()) {
+    if (e.text() && isNumberType(e.type())) {
+        code += "result.setValue( " + numberReader(e.type()) + "( element ) );";
+    } else if (e.text()) {
         code += "result.setValue( " + stringToDataConverter("element.text()", e.type()) + " );";
     }
 
     const auto attributeRelations = e.attributeRelations();
+
+    if (creator()->validate()) {
+        for (const Schema::Relation &r : attributeRelations) {
+            const Schema::Attribute &a = creator()->document().attribute(r, e.name());
+            if (!a.required()) {
+                continue;
+            }
+            code += "if ( !element.hasAttribute( " + Creator::stringLiteral(a.name()) + " ) ) {";
+            code += "  " + creator()->errorStream() + " << \"Missing attribute '" + a.name()
+                    + "' in '" + e.name()
+                    + "' at \" << element.lineNumber() << \",\" << element.columnNumber();";
+            code += "  valid = false;";
+            code += '}';
+        }
+    }
+
+    // Each attribute node is looked up once and used for the conversion as
+    // well as for error reporting.
     for (const Schema::Relation &r : attributeRelations) {
-        Schema::Attribute a = creator()->document().attribute(r, e.name());
+        const Schema::Attribute &a = creator()->document().attribute(r, e.name());
 
         if (a.enumerationValues().count()) {
             QString enumName = Namer::sanitize(a.name());
+            QString attributeName = enumName + "Attribute";
 
+            code += "const QDomAttr " + attributeName + " = element.attributeNode( "
+                    + Creator::stringLiteral(a.name()) + " );";
             if (!a.required()) { // if not required generate conditions
-                code += "if (element.hasAttribute(\"" + a.name() + "\"))  {";
+                code += "if ( !" + attributeName + ".isNull() ) {";
                 code.indent();
             }
-            code += Namer::getClassName(a.name()) + "Enum" + " " + enumName + " = "
-                    + KODE::Style::lowerFirst(Namer::getClassName(a.name()))
-                    + "EnumFromString( element.attribute( \"" + a.name() + "\" ), ok  );";
+            code += c.name() + "::" + Namer::getClassName(a.name()) + "Enum" + " " + enumName
+                    + " = " + c.name() + "::"
+                    + KODE::Style::lowerFirst(Namer::getClassName(a.name())) + "EnumFromName( "
+                    + attributeName + ".value(), ok );";
             code += "if (ok && *ok == false) {";
             code.indent();
-            code += "qCritical() << \"Invalid string: \\\"\" << element.attribute( \"" + a.name()
-                    + "\" ) << \"\\\" in the \\\"" + a.name() + "\\\" element\";";
+            code += "qCritical() << \"Invalid string: \\\"\" << " + attributeName
+                    + ".value() << \"\\\" in the \\\"" + a.name() + "\\\" element\";";
             code += "return " + c.name() + "();";
             code.unindent();
             code += "} else {";
@@ -160,21 +238,28 @@ void ParserCreatorDom::createElementParser(KODE::Class &c, const Schema::Element
                 code.unindent();
                 code += "} else {";
                 code.indent();
-                code += "result.set" + Namer::getClassName(a.name()) + "("
-                        + KODE::Style::lowerFirst(Namer::getClassName(a.name()))
-                        + "EnumFromString(\"" + a.defaultValue() + "\"));";
+                code += "result.set" + Namer::getClassName(a.name()) + "( "
+                        + enumDefaultValue(c.name(), a) + " );";
                 code.unindent();
                 code += "}";
             }
         } else {
-            QString data =
-                    stringToDataConverter("element.attribute( \"" + a.name() + "\" )", a.type());
+            QString attribute = "element.attribute( " + Creator::stringLiteral(a.name()) + " )";
+            QString data = stringToDataConverter(attribute, a.type());
 
             code += "result.set" + Namer::getClassName(a.name()) + "( " + data + " );";
         }
     }
     code.newLine();
 
+    if (creator()->validate()) {
+        code += createValidityCheck(c.name());
+    }
+
+    // Parsed objects keep the timestamps of the document
+    if (creator()->hasPendingTimestamps(e)) {
+        code += "result.clearPendingTimestamps();";
+    }
     code += "if ( ok ) *ok = true;";
     code += "return result;";
 
@@ -183,9 +268,83 @@ void ParserCreatorDom::createElementParser(KODE::Class &c, const Schema::Element
     if (creator()->externalParser()) {
         creator()->parserClass().addFunction(parser);
         creator()->parserClass().addHeaderInclude("qdom.h");
+        creator()->parserClass().addInclude("utility");
     } else {
         c.addFunction(parser);
     }
+
+    if (parallel) {
+        KODE::Class &target = creator()->externalParser() ? creator()->parserClass() : c;
+        target.addInclude("QFuture");
+        target.addInclude("QThread");
+        target.addInclude("QVector");
+        target.addInclude("QtConcurrentRun");
+    }
+}
+
+KODE::Code ParserCreatorDom::createParallelListParser(const QString &className)
+{
+    const QString name = KODE::Style::lowerFirst(className);
+    const QString elements = name + "Elements";
+    const QString items = name + "Items";
+    const QString count = name + "Count";
+
+    QString parseFunction;
+    if (creator()->externalParser()) {
+        parseFunction = "parseElement" + className;
+    } else {
+        parseFunction = className + "::parseElement";
+    }
+
+    KODE::Code code;
+
+    code += "auto parse" + className + "Items = []( const QVector<QDomElement> &elements, "
+                                       "int begin, int end ) {";
+    code.indent();
+    code += className + "::List items;";
+    code += "items.reserve( end - begin );";
+    code += "for ( int i = begin; i < end; ++i ) {";
+    code += "  bool ok;";
+    code += "  " + className + " o = " + parseFunction + "( elements.at( i ), &ok );";
+    code += "  if ( ok ) items.append( o );";
+    code += '}';
+    code += "return items;";
+    code.unindent();
+    code += "};";
+    code.newLine();
+
+    code += className + "::List " + items + ';';
+    code += "const int " + count + " = " + elements + ".size();";
+    code += "if ( " + count + " < 1024 ) {";
+    code += "  " + items + " = parse" + className + "Items( " + elements + ", 0, " + count + " );";
+    code += "} else {";
+    code.indent();
+    code += "// Chunks are parsed in parallel and concatenated in document order";
+    code += "const int chunkSize = qMax( 256, " + count
+            + " / ( QThread::idealThreadCount() * 4 ) );";
+    code += "QList<QFuture<" + className + "::List>> futures;";
+    code += "for ( int begin = 0; begin < " + count + "; begin += chunkSize ) {";
+    code.indent();
+    code += "const int end = qMin( begin + chunkSize, " + count + " );";
+    code += "futures.append( QtConcurrent::run( [&" + elements + ", &parse" + className
+            + "Items, begin, end]() {";
+    code += "  return parse" + className + "Items( " + elements + ", begin, end );";
+    code += "} ) );";
+    code.unindent();
+    code += '}';
+    code += items + ".reserve( " + count + " );";
+    code += "for ( QFuture<" + className + "::List> &future : futures ) {";
+    code += "  " + items + " += future.result();";
+    code += '}';
+    code.unindent();
+    code += '}';
+    if (creator()->validate()) {
+        // Items which couldn't be parsed were dropped by the workers
+        code += "if ( " + items + ".size() != " + count + " ) valid = false;";
+    }
+    code += "result.set" + className + "List( std::move( " + items + " ) );";
+
+    return code;
 }
 
 void ParserCreatorDom::createFileParser(const Schema::Element &element)
@@ -215,6 +374,7 @@ void ParserCreatorDom::createFileParser(const Schema::Element &element)
     parser.addArgument("bool *ok");
 
     c.addInclude("QFile");
+    c.addInclude("limits");
     c.addInclude("QDomDocument");
 
     KODE::Code code;
@@ -226,6 +386,8 @@ void ParserCreatorDom::createFileParser(const Schema::Element &element)
     code += "  return " + className + "();";
     code += '}';
     code += "";
+    code += createMappedFileParser(className);
+    code += "";
     code += "QString errorMsg;";
     code += "int errorLine, errorCol;";
     code += "QDomDocument doc;";
@@ -264,6 +426,76 @@ void ParserCreatorDom::createFileParser(const Schema::Element &element)
         c.setQGadget(c.enums().count());
 }
 
+void ParserCreatorDom::createBufferParser(const Schema::Element &element)
+{
+    QString className = Namer::getClassName(element.name());
+
+    KODE::Class c;
+
+    if (creator()->externalParser()) {
+        c = creator()->parserClass();
+    } else {
+        c = creator()->file().findClass(className);
+    }
+
+    if (creator()->useKde()) {
+        c.addInclude("qDebug.h");
+    } else {
+        c.addInclude("QtDebug");
+    }
+
+    KODE::Function parser("parseBuffer", className);
+    parser.setStatic(true);
+    parser.setDocs("Parse XML document from UTF-8 encoded data. The data is not copied and has to "
+                   "stay valid until the function returns.");
+
+    parser.addArgument("const char *data");
+    parser.addArgument("size_t size");
+    parser.addArgument("bool *ok");
+
+    c.addInclude("QDomDocument");
+    c.addInclude("limits");
+
+    KODE::Code code;
+
+    code += createBufferSizeCheck(className);
+    code.newLine();
+    code += "QString errorMsg;";
+    code += "int errorLine, errorCol;";
+    code += "QDomDocument doc;";
+    code += "if ( !doc.setContent( QByteArray::fromRawData( data, int( size ) ), false, &errorMsg, "
+            "&errorLine, &errorCol ) ) {";
+    code += "  " + creator()->errorStream()
+            + " << errorMsg << \" at \" << errorLine << \",\" << errorCol;";
+    code += "  if ( ok ) *ok = false;";
+    code += "  return " + className + "();";
+    code += '}';
+
+    code.newLine();
+
+    code += "bool documentOk;";
+    QString line = className + " c = parseElement";
+    if (creator()->externalParser())
+        line += className;
+    line += "( doc.documentElement(), &documentOk );";
+    code += line;
+
+    code += "if ( ok ) {";
+    code += "  *ok = documentOk;";
+    code += '}';
+    code += "return c;";
+
+    parser.setBody(code);
+
+    c.addFunction(parser);
+
+    if (creator()->externalParser()) {
+        creator()->setParserClass(c);
+    } else {
+        creator()->file().insertClass(c);
+    }
+}
+
 void ParserCreatorDom::createStringParser(const Schema::Element &element)
 {
     QString className = Namer::getClassName(element.name());
@@ -328,25 +560,31 @@ void ParserCreatorDom::createStringParser(const Schema::Element &element)
     }
 }
 
-QString ParserCreatorDom::stringToDataConverter(const QString &data, Schema::Node::Type type)
+KODE::Function ParserCreatorDom::createNumberReader(const QString &name, const QString &typeName,
+                                                    const QString &converter)
 {
-    QString converter;
-    if (type == Schema::Element::Int) {
-        converter = data + ".toInt()";
-    } else if (type == Schema::Element::UnsignedLong) {
-        converter = data + ".toULongLong()";
-    } else if (type == Schema::Element::Integer) {
-        converter = data + ".toLongLong()";
-    } else if (type == Schema::Element::Decimal) {
-        converter = data + ".toDouble()";
-    } else if (type == Schema::Element::Boolean) {
-        converter = "(" + data + " == \"1\" || " + data + " == \"true\")";
-    } else if (type == Schema::Element::Date) {
-        converter = "QDate::fromString( " + data + ", \"yyyyMMdd\" )";
-    } else if (type == Schema::Element::DateTime) {
-        converter = "QDateTime::fromString( " + data + ", \"yyyyMMddThhmmssZ\" )";
-    } else {
-        converter = data;
-    }
-    return converter;
+    KODE::Function reader(name, typeName);
+    reader.setStatic(true);
+    reader.addArgument("const QDomElement &element");
+
+    KODE::Code code;
+
+    // The text of a number is a single text node. Its data is shared, while
+    // QDomElement::text() concatenates the text of all children into a new
+    // string.
+    code += "const QDomNode child = element.firstChild();";
+    code += "const QString text = child.isText() && child.nextSibling().isNull()";
+    code += "                     ? child.toText().data()";
+    code += "                     : element.text();";
+    code += "bool ok = false;";
+    code += "const " + typeName + " value = text." + converter + "( &ok );";
+    code += "if ( !ok && !text.isEmpty() ) {";
+    code += "  " + creator()->errorStream()
+            + " << \"Invalid number\" << text << \"at line\" << element.lineNumber();";
+    code += '}';
+    code += "return value;";
+
+    reader.setBody(code);
+
+    return reader;
 }
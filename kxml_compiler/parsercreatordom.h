@@ -35,9 +35,18 @@ public:
     void createFileParser(const Schema::Element &element);
     void createStringParser(const Schema::Element &element);
     void createElementParser(KODE::Class &c, const Schema::Element &e);
+    void createBufferParser(const Schema::Element &element);
 
 protected:
-    QString stringToDataConverter(const QString &data, Schema::Node::Type);
+    /**
+      Create code parsing the elements collected in the QVector
+      "<className>Elements", in parallel if there are many of them, and
+      setting the resulting list on "result".
+    */
+    KODE::Code createParallelListParser(const QString &className);
+
+    KODE::Function createNumberReader(const QString &name, const QString &typeName,
+                                      const QString &converter);
 };
 
 #endif
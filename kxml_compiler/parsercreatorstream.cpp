@@ -0,0 +1,788 @@
+/*
+    This file is part of KDE.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+
+#include "parsercreatorstream.h"
+
+#include "namer.h"
+#include "style.h"
+
+#include <code_generation/code.h>
+
+#include <QDebug>
+
+ParserCreatorStream::ParserCreatorStream(Creator *c) : ParserCreator(c) {}
+
+void ParserCreatorStream::createElementParser(KODE::Class &c, const Schema::Element &e)
+{
+    QString functionName;
+    if (creator()->externalParser())
+        functionName = "parseElement" + c.name();
+    else
+        functionName = "parseElement";
+
+    KODE::Function parser(functionName, c.name());
+    parser.setStatic(true);
+    parser.setDocs("Parse XML object from stream reader positioned on its start element. "
+                   "On return the reader is positioned on the matching end element.");
+
+    c.addHeaderInclude("QXmlStreamReader");
+
+    parser.addArgument("QXmlStreamReader &xml");
+    parser.addArgument("bool *ok");
+
+    const bool visitable = isVisitable(e);
+    if (visitable) {
+        parser.addArgument(KODE::Function::Argument(creator()->visitorClassName() + " *visitor",
+                                                    "nullptr"));
+    }
+
+    // The start element optionally takes over unchanged list items from a
+    // previously parsed version of the document, see createUpdateFunction()
+    const bool incremental = isIncremental(e);
+    if (incremental) {
+        parser.addArgument(KODE::Function::Argument("const QString *source", "nullptr"));
+        parser.addArgument(KODE::Function::Argument("const " + c.name() + " *previous", "nullptr"));
+        c.addInclude("QHash");
+        c.addFunction(createSourceHash());
+    }
+
+    KODE::Code code;
+
+    code += "if ( xml.name() != " + Creator::comparisonLiteral(e.name()) + " ) {";
+    code.indent();
+    code += creator()->errorStream() + " << \"Expected '" + e.name()
+            + "', got '\" << xml.name() << \"'.\";";
+    code += "xml.skipCurrentElement();";
+    code += "if ( ok ) *ok = false;";
+    code += "return " + c.name() + "();";
+    code.unindent();
+    code += '}';
+    code.newLine();
+
+    code += c.name() + " result = " + c.name() + "();";
+    if (creator()->validate()) {
+        code += "bool valid = true;";
+
+        // The position of the start element is used for reporting violations
+        // found at its end, so it's only kept if there is something to check
+        bool reportsPosition = false;
+        const auto attributeRelations = e.attributeRelations();
+        for (const Schema::Relation &r : attributeRelations) {
+            const Schema::Attribute &a = creator()->document().attribute(r, e.name());
+            if (a.required() && a.enumerationValues().isEmpty()) {
+                reportsPosition = true;
+            }
+        }
+        const auto elementRelations = e.elementRelations();
+        for (const Schema::Relation &r : elementRelations) {
+            if (isCountedRelation(r)) {
+                reportsPosition = true;
+            }
+        }
+        if (reportsPosition) {
+            code += "const qint64 lineNumber = xml.lineNumber();";
+            code += "const qint64 columnNumber = xml.columnNumber();";
+        }
+    }
+    code.newLine();
+
+    // Attributes belong to the start element token, so they have to be read
+    // before the reader advances into the content of the element. They are
+    // read in a single pass, dispatching on the attribute name.
+    if (e.hasAttributeRelations()) {
+        QStringList attributeNames;
+        QList<KODE::Code> attributeBranches;
+        QStringList requiredEnums;
+        QStringList requiredAttributes;
+
+        const auto attributeRelations = e.attributeRelations();
+        for (const Schema::Relation &r : attributeRelations) {
+            const Schema::Attribute &a = creator()->document().attribute(r, e.name());
+
+            const QString className = Namer::getClassName(a.name());
+
+            KODE::Code branch;
+
+            if (a.enumerationValues().count()) {
+                QString enumName = Namer::sanitize(a.name());
+                QString converter =
+                        c.name() + "::" + KODE::Style::lowerFirst(className) + "EnumFromName";
+
+                if (a.required()) {
+                    requiredEnums.append(a.name());
+                    code += "bool has" + className + " = false;";
+                } else {
+                    code += "result.set" + className + "( " + enumDefaultValue(c.name(), a)
+                            + " );";
+                }
+
+                branch += c.name() + "::" + className + "Enum " + enumName + " = " + converter
+                        + "( attribute.value(), ok );";
+                branch += "if ( ok && *ok == false ) {";
+                branch.indent();
+                branch += "qCritical() << \"Invalid string: \\\"\" << attribute.value()"
+                          " << \"\\\" in the \\\""
+                        + a.name() + "\\\" element\";";
+                branch += "xml.skipCurrentElement();";
+                branch += "return " + c.name() + "();";
+                branch.unindent();
+                branch += '}';
+                branch += "result.set" + className + "( " + enumName + " );";
+                if (a.required()) {
+                    branch += "has" + className + " = true;";
+                }
+            } else {
+                if (creator()->validate() && a.required()) {
+                    requiredAttributes.append(a.name());
+                    code += "bool has" + className + " = false;";
+                    branch += "has" + className + " = true;";
+                }
+
+                if (isNumberType(a.type())) {
+                    // QStringRef converts without creating a temporary string
+                    branch += "result.set" + className + "( "
+                            + stringToDataConverter("attribute.value()", a.type()) + " );";
+                } else {
+                    branch += "result.set" + className + "( "
+                            + stringToDataConverter("attribute.value().toString()", a.type())
+                            + " );";
+                }
+            }
+
+            attributeNames.append(a.name());
+            attributeBranches.append(branch);
+        }
+
+        code += "const QXmlStreamAttributes attributes = xml.attributes();";
+        code += "for ( const QXmlStreamAttribute &attribute : attributes ) {";
+        code.indent();
+        code += "const QStringRef attributeName = attribute.qualifiedName();";
+        code += createTagDispatcher("attributeName", attributeNames, attributeBranches);
+        code.unindent();
+        code += '}';
+
+        for (const QString &name : qAsConst(requiredEnums)) {
+            const QString className = Namer::getClassName(name);
+            code += "if ( !has" + className + " ) {";
+            code.indent();
+            code += "qCritical() << \"Missing attribute \\\"" + name + "\\\" in the \\\""
+                    + e.name() + "\\\" element\";";
+            code += "xml.skipCurrentElement();";
+            code += "if ( ok ) *ok = false;";
+            code += "return " + c.name() + "();";
+            code.unindent();
+            code += '}';
+        }
+
+        // Missing attributes are reported together with the other violations
+        // after reading the element
+        for (const QString &name : qAsConst(requiredAttributes)) {
+            const QString className = Namer::getClassName(name);
+            code += "if ( !has" + className + " ) {";
+            code += "  " + creator()->errorStream() + " << \"Missing attribute '" + name
+                    + "' in '" + e.name() + "' at \" << lineNumber << \",\" << columnNumber;";
+            code += "  valid = false;";
+            code += '}';
+        }
+        code.newLine();
+    }
+
+    if (e.hasElementRelations()) {
+        if (e.text()) {
+            code += "QString text;";
+        }
+        code += createOccurrenceCounters(e);
+        if (incremental) {
+            const auto elementRelations = e.elementRelations();
+            for (const Schema::Relation &r : elementRelations) {
+                if (!r.isList()) {
+                    continue;
+                }
+                const QString className = Namer::getClassName(r.target());
+                const QString index = "previous" + className + "Index";
+                const QString hashes =
+                        "previous->" + creator()->constMemberAccess("m" + className + "ListHashes");
+                const QString items =
+                        "previous->" + creator()->constMemberAccess("m" + className + "List");
+                code += "QHash<quint64, int> " + index + ';';
+                code += "if ( source && previous && " + hashes + ".size() == " + items
+                        + ".size() ) {";
+                code.indent();
+                code += index + ".reserve( " + hashes + ".size() );";
+                code += "for ( int i = 0; i < " + hashes + ".size(); ++i ) {";
+                code += "  " + index + ".insert( " + hashes + ".at( i ), i );";
+                code += '}';
+                code.unindent();
+                code += '}';
+            }
+        }
+        code += "while ( !xml.atEnd() ) {";
+        code.indent();
+        if (incremental) {
+            code += "const int itemStart = int( xml.characterOffset() );";
+        }
+        code += "xml.readNext();";
+        code += "if ( xml.isEndElement() ) {";
+        code += "  break;";
+        code += "}";
+        if (e.text()) {
+            code += "if ( xml.isCharacters() ) {";
+            code += "  text += xml.text();";
+            code += "  continue;";
+            code += "}";
+        }
+        code += "if ( !xml.isStartElement() ) {";
+        code += "  continue;";
+        code += "}";
+        code.newLine();
+
+        code += "const QStringRef name = xml.name();";
+
+        QStringList tags;
+        QList<KODE::Code> branches;
+
+        const auto elementRelations = e.elementRelations();
+        for (const Schema::Relation &r : elementRelations) {
+            KODE::Code branch;
+
+            QString className = Namer::getClassName(r.target());
+
+            const Schema::Element &targetElement = creator()->document().element(r.target());
+
+            if (targetElement.text() && !targetElement.hasAttributeRelations() && !r.isList()
+                && isNumberType(targetElement.type())) {
+                branch += "result.set" + className + "( " + numberReader(targetElement.type())
+                        + "( xml ) );";
+            } else if (targetElement.text() && !targetElement.hasAttributeRelations()
+                       && !r.isList()) {
+                branch += "const QString value = "
+                          "xml.readElementText( QXmlStreamReader::IncludeChildElements );";
+                QString data = stringToDataConverter("value", targetElement.type());
+                branch += "result.set" + className + "( " + data + " );";
+            } else {
+                branch += "bool ok;";
+                QString line = className + " o = ";
+                if (creator()->externalParser()) {
+                    line += "parseElement" + className;
+                } else {
+                    line += className + "::parseElement";
+                }
+                line += "( xml, &ok );";
+                branch += line;
+
+                if (r.isList() && visitable) {
+                    branch += "if ( ok ) {";
+                    branch += "  if ( visitor ) visitor->on" + className + "( o );";
+                    branch += "  else result.add" + className + "( std::move( o ) );";
+                    branch += "}";
+                } else if (r.isList()) {
+                    branch += "if ( ok ) result.add" + className + "( std::move( o ) );";
+                } else {
+                    branch += "if ( ok ) result.set" + className + "( std::move( o ) );";
+                }
+                branch += createChildFailureCheck();
+
+                if (incremental && r.isList()) {
+                    branch = createIncrementalItemParser(className, branch);
+                }
+            }
+
+            if (isCountedRelation(r)) {
+                KODE::Code countedBranch;
+                countedBranch += "++" + occurrenceCounter(r) + ';';
+                countedBranch += branch;
+                branch = countedBranch;
+            }
+
+            tags.append(r.target());
+            branches.append(branch);
+        }
+
+        KODE::Code skip;
+        skip += "xml.skipCurrentElement();";
+        code += createTagDispatcher("name", tags, branches, skip);
+
+        code.unindent();
+        code += '}';
+        code.newLine();
+
+        if (e.text()) {
+            code += "result.setValue( " + stringToDataConverter("text", e.type()) + " );";
+        }
+
+        code += createOccurrenceChecks(e, "lineNumber", "columnNumber");
+    } else if (e.text() && isNumberType(e.type())) {
+        code += "result.setValue( " + numberReader(e.type()) + "( xml ) );";
+    } else if (e.text()) {
+        code += "const QString value = "
+                "xml.readElementText( QXmlStreamReader::IncludeChildElements );";
+        code += "result.setValue( " + stringToDataConverter("value", e.type()) + " );";
+    } else {
+        code += "xml.skipCurrentElement();";
+    }
+    code.newLine();
+
+    if (creator()->validate()) {
+        code += createValidityCheck(c.name());
+    }
+
+    // Parsed objects keep the timestamps of the document
+    if (creator()->hasPendingTimestamps(e)) {
+        code += "result.clearPendingTimestamps();";
+    }
+    code += "if ( ok ) *ok = !xml.hasError();";
+    code += "return result;";
+
+    parser.setBody(code);
+
+    if (creator()->externalParser()) {
+        creator()->parserClass().addFunction(parser);
+        creator()->parserClass().addHeaderInclude("QXmlStreamReader");
+        creator()->parserClass().addInclude("utility");
+    } else {
+        c.addFunction(parser);
+    }
+}
+
+bool ParserCreatorStream::isVisitable(const Schema::Element &e) const
+{
+    return creator()->createVisitor()
+            && e.identifier() == creator()->document().startElement().identifier();
+}
+
+bool ParserCreatorStream::isIncremental(const Schema::Element &e) const
+{
+    return creator()->incremental()
+            && e.identifier() == creator()->document().startElement().identifier();
+}
+
+KODE::Function ParserCreatorStream::createSourceHash()
+{
+    KODE::Function sourceHash("sourceHash", "quint64");
+    sourceHash.setStatic(true);
+    sourceHash.setAccess(KODE::Function::Private);
+    sourceHash.addArgument("const QStringRef &source");
+
+    // Two differently seeded hashes make collisions between the items of
+    // large lists unlikely enough to identify items by their hash
+    KODE::Code code;
+    code += "return ( quint64( qHash( source, 0x9e3779b9 ) ) << 32 )";
+    code += "       | qHash( source, 0x85ebca6b );";
+    sourceHash.setBody(code);
+
+    return sourceHash;
+}
+
+KODE::Code ParserCreatorStream::createIncrementalItemParser(const QString &className,
+                                                            const KODE::Code &itemParser)
+{
+    const QString index = "previous" + className + "Index";
+    const QString hashes = "result." + creator()->memberAccess("m" + className + "ListHashes");
+    // The adder discards the hashes, so the items are appended directly
+    const QString items = "result." + creator()->memberAccess("m" + className + "List");
+
+    KODE::Code code;
+
+    code += "if ( source ) {";
+    code.indent();
+    code += "xml.skipCurrentElement();";
+    code += "const int itemEnd = int( xml.characterOffset() );";
+    code += "const QStringRef itemSource = source->midRef( itemStart, itemEnd - itemStart );";
+    code += "const quint64 hash = sourceHash( itemSource );";
+    code += "const auto previousItem = " + index + ".constFind( hash );";
+    code += "if ( previousItem != " + index + ".constEnd() ) {";
+    code.indent();
+    code += items + ".append( previous->" + creator()->constMemberAccess("m" + className + "List")
+            + ".at( previousItem.value() ) );";
+    code += hashes + ".append( hash );";
+    code.unindent();
+    code += "} else {";
+    code.indent();
+    code += "QXmlStreamReader itemXml( itemSource.toString() );";
+    code += "itemXml.readNextStartElement();";
+    code += "bool itemOk;";
+    code += className + " o = " + className + "::parseElement( itemXml, &itemOk );";
+    code += "// The item may depend on declarations of the document, like namespace";
+    code += "// prefixes or entities. update() then parses the document as a whole.";
+    code += "if ( !itemOk || itemXml.hasError() ) {";
+    code += "  if ( ok ) *ok = false;";
+    code += "  return " + Namer::getClassName(creator()->document().startElement().name())
+            + "();";
+    code += '}';
+    code += items + ".append( std::move( o ) );";
+    code += hashes + ".append( hash );";
+    code.unindent();
+    code += '}';
+    code.unindent();
+    code += "} else {";
+    code.indent();
+    code += itemParser;
+    code.unindent();
+    code += '}';
+
+    return code;
+}
+
+void ParserCreatorStream::createUpdateFunction(const Schema::Element &element)
+{
+    QString className = Namer::getClassName(element.name());
+
+    KODE::Class c = creator()->file().findClass(className);
+
+    KODE::Function update("update", "bool");
+    update.setDocs("Parse the XML document from the UTF-8 encoded content and replace the data of "
+                   "this object with it. Items of the lists whose source didn't change since the "
+                   "last update are taken over from this object instead of being parsed again. "
+                   "Changing a list of this object makes all its items be parsed again. Returns "
+                   "false and leaves the object unchanged, if the document can't be parsed.");
+    update.addArgument("const QByteArray &content");
+
+    c.addHeaderInclude("QByteArray");
+    c.addInclude("QXmlStreamReader");
+    c.addInclude("utility");
+
+    KODE::Code code;
+
+    code += "const QString source = QString::fromUtf8( content );";
+    code += "QXmlStreamReader xml( source );";
+    code += "if ( !xml.readNextStartElement() ) {";
+    code += "  " + creator()->errorStream()
+            + " << xml.errorString() << \" at \" << xml.lineNumber() << \",\" << "
+              "xml.columnNumber();";
+    code += "  return false;";
+    code += '}';
+    code.newLine();
+
+    code += "bool ok;";
+    QString line = className + " c = parseElement( xml, &ok";
+    if (isVisitable(element)) {
+        line += ", nullptr";
+    }
+    line += ", &source, this );";
+    code += line;
+    code += "if ( !ok && !xml.hasError() ) {";
+    code.indent();
+    code += "// Changed items are parsed from their own source text. If one of them";
+    code += "// can't be parsed without the rest of the document, parse everything.";
+    code += "xml.clear();";
+    code += "xml.addData( source );";
+    code += "xml.readNextStartElement();";
+    code += "c = parseElement( xml, &ok );";
+    code.unindent();
+    code += '}';
+    code += "if ( xml.hasError() ) {";
+    code += "  " + creator()->errorStream()
+            + " << xml.errorString() << \" at \" << xml.lineNumber() << \",\" << "
+              "xml.columnNumber();";
+    code += "  ok = false;";
+    code += '}';
+    code += "if ( !ok ) {";
+    code += "  return false;";
+    code += '}';
+    code.newLine();
+    code += "*this = std::move( c );";
+    code += "return true;";
+
+    update.setBody(code);
+
+    c.addFunction(update);
+
+    creator()->file().insertClass(c);
+}
+
+KODE::Code ParserCreatorStream::createDocumentParser(const QString &className,
+                                                     const QString &extraArguments)
+{
+    KODE::Code code;
+
+    code += "if ( !xml.readNextStartElement() ) {";
+    code += "  " + creator()->errorStream()
+            + " << xml.errorString() << \" at \" << xml.lineNumber() << \",\" << "
+              "xml.columnNumber();";
+    code += "  if ( ok ) *ok = false;";
+    code += "  return " + className + "();";
+    code += '}';
+
+    code.newLine();
+
+    code += "bool documentOk;";
+    QString line = className + " c = parseElement";
+    if (creator()->externalParser())
+        line += className;
+    line += "( xml, &documentOk" + extraArguments + " );";
+    code += line;
+
+    code += "if ( xml.hasError() ) {";
+    code += "  " + creator()->errorStream()
+            + " << xml.errorString() << \" at \" << xml.lineNumber() << \",\" << "
+              "xml.columnNumber();";
+    code += "  documentOk = false;";
+    code += '}';
+    code += "if ( ok ) {";
+    code += "  *ok = documentOk;";
+    code += '}';
+    code += "return c;";
+
+    return code;
+}
+
+void ParserCreatorStream::createFileParser(const Schema::Element &element)
+{
+    QString className = Namer::getClassName(element.name());
+
+    KODE::Class c;
+
+    if (creator()->externalParser()) {
+        c = creator()->parserClass();
+    } else {
+        c = creator()->file().findClass(className);
+    }
+
+    if (creator()->useKde()) {
+        c.addInclude("qDebug.h");
+    } else {
+        c.addInclude("QtDebug");
+    }
+
+    KODE::Function parser("parseFile", className);
+    parser.setStatic(true);
+
+    parser.addArgument("const QString &filename");
+    parser.addArgument("bool *ok");
+
+    c.addInclude("QFile");
+    c.addInclude("limits");
+    c.addInclude("QXmlStreamReader");
+
+    KODE::Code code;
+
+    code += "QFile file( filename );";
+    code += "if ( !file.open( QIODevice::ReadOnly ) ) {";
+    code += "  " + creator()->errorStream() + " << \"Unable to open file '\" << filename << \"'\";";
+    code += "  if ( ok ) *ok = false;";
+    code += "  return " + className + "();";
+    code += '}';
+    code += "";
+    KODE::Code openCode = code;
+
+    code += createMappedFileParser(className);
+    code += "";
+    code += "QXmlStreamReader xml( &file );";
+    code += createDocumentParser(className);
+
+    parser.setBody(code);
+
+    c.addFunction(parser);
+
+    if (isVisitable(element)) {
+        KODE::Function visitor("visitFile", className);
+        visitor.setStatic(true);
+        visitor.setDocs("Parse file and pass the items of the contained lists to the visitor "
+                        "instead of collecting them in the returned object.");
+
+        visitor.addArgument("const QString &filename");
+        visitor.addArgument(creator()->visitorClassName() + " &visitor");
+        visitor.addArgument("bool *ok");
+
+        code = openCode;
+        code += "QXmlStreamReader xml( &file );";
+        code += createDocumentParser(className, ", &visitor");
+
+        visitor.setBody(code);
+
+        c.addFunction(visitor);
+    }
+
+    if (creator()->externalParser()) {
+        creator()->setParserClass(c);
+    } else {
+        creator()->file().insertClass(c);
+    }
+
+    if (creator()->useQEnums())
+        c.setQGadget(c.enums().count());
+}
+
+void ParserCreatorStream::createBufferParser(const Schema::Element &element)
+{
+    QString className = Namer::getClassName(element.name());
+
+    KODE::Class c;
+
+    if (creator()->externalParser()) {
+        c = creator()->parserClass();
+    } else {
+        c = creator()->file().findClass(className);
+    }
+
+    if (creator()->useKde()) {
+        c.addInclude("qDebug.h");
+    } else {
+        c.addInclude("QtDebug");
+    }
+
+    KODE::Function parser("parseBuffer", className);
+    parser.setStatic(true);
+    parser.setDocs("Parse XML document from UTF-8 encoded data. The data is not copied and has to "
+                   "stay valid until the function returns.");
+
+    parser.addArgument("const char *data");
+    parser.addArgument("size_t size");
+    parser.addArgument("bool *ok");
+
+    c.addInclude("QBuffer");
+    c.addInclude("QXmlStreamReader");
+    c.addInclude("limits");
+
+    KODE::Code code;
+
+    code += createBufferSizeCheck(className);
+    code.newLine();
+    // Reading through a device makes the reader decode the data in chunks
+    // instead of converting the whole document to a QString up front
+    code += "QBuffer buffer;";
+    code += "buffer.setData( QByteArray::fromRawData( data, int( size ) ) );";
+    code += "buffer.open( QIODevice::ReadOnly );";
+    code += "QXmlStreamReader xml( &buffer );";
+    code += createDocumentParser(className);
+
+    parser.setBody(code);
+
+    c.addFunction(parser);
+
+    if (creator()->externalParser()) {
+        creator()->setParserClass(c);
+    } else {
+        creator()->file().insertClass(c);
+    }
+}
+
+void ParserCreatorStream::createStringParser(const Schema::Element &element)
+{
+    QString className = Namer::getClassName(element.name());
+
+    KODE::Class c;
+
+    if (creator()->externalParser()) {
+        c = creator()->parserClass();
+    } else {
+        c = creator()->file().findClass(className);
+    }
+
+    if (creator()->useKde()) {
+        c.addInclude("qDebug.h");
+    } else {
+        c.addInclude("QtDebug");
+    }
+
+    KODE::Function parser("parseString", className);
+    parser.setStatic(true);
+
+    parser.addArgument("const QString &data");
+    parser.addArgument("bool *ok");
+
+    c.addInclude("QXmlStreamReader");
+
+    KODE::Code code;
+
+    code += "QXmlStreamReader xml( data );";
+    code += createDocumentParser(className);
+
+    parser.setBody(code);
+
+    c.addFunction(parser);
+
+    if (isVisitable(element)) {
+        KODE::Function visitor("visitString", className);
+        visitor.setStatic(true);
+        visitor.setDocs("Parse string and pass the items of the contained lists to the visitor "
+                        "instead of collecting them in the returned object.");
+
+        visitor.addArgument("const QString &data");
+        visitor.addArgument(creator()->visitorClassName() + " &visitor");
+        visitor.addArgument("bool *ok");
+
+        code.clear();
+        code += "QXmlStreamReader xml( data );";
+        code += createDocumentParser(className, ", &visitor");
+
+        visitor.setBody(code);
+
+        c.addFunction(visitor);
+    }
+
+    if (creator()->externalParser()) {
+        creator()->setParserClass(c);
+    } else {
+        creator()->file().insertClass(c);
+    }
+}
+
+KODE::Function ParserCreatorStream::createNumberReader(const QString &name,
+                                                       const QString &typeName,
+                                                       const QString &converter)
+{
+    KODE::Function reader(name, typeName);
+    reader.setStatic(true);
+    reader.addArgument("QXmlStreamReader &xml");
+
+    KODE::Code code;
+
+    // The text of a leaf arrives as a single chunk, which is converted
+    // directly from the buffer of the reader without copying it. That buffer
+    // is overwritten by the next token, so a number split into several chunks
+    // by comments or CDATA sections can't be put together again and is
+    // reported as invalid. Whitespace around the number is ignored.
+    code += typeName + " value = 0;";
+    code += "bool ok = true;";
+    code += "int chunks = 0;";
+    code += "QString invalidText;";
+    code += "while ( !xml.atEnd() ) {";
+    code.indent();
+    code += "xml.readNext();";
+    code += "if ( xml.isEndElement() ) {";
+    code += "  break;";
+    code += '}';
+    code += "if ( xml.isCharacters() && !xml.isWhitespace() ) {";
+    code.indent();
+    code += "const QStringRef chunk = xml.text();";
+    code += "if ( chunks++ == 0 ) {";
+    code += "  value = chunk." + converter + "( &ok );";
+    code += "} else {";
+    code += "  ok = false;";
+    code += '}';
+    code += "if ( !ok ) {";
+    code += "  invalidText += chunk;";
+    code += '}';
+    code.unindent();
+    code += "} else if ( xml.isStartElement() ) {";
+    code += "  xml.skipCurrentElement();";
+    code += '}';
+    code.unindent();
+    code += '}';
+    code += "if ( !ok ) {";
+    code += "  " + creator()->errorStream()
+            + " << \"Invalid number\" << invalidText << \"at line\" << xml.lineNumber();";
+    code += '}';
+    code += "return value;";
+
+    reader.setBody(code);
+
+    return reader;
+}
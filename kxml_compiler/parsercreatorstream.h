@@ -0,0 +1,58 @@
+/*
+    This file is part of KDE.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Library General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Library General Public License for more details.
+
+    You should have received a copy of the GNU Library General Public License
+    along with this library; see the file COPYING.LIB.  If not, write to
+    the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+    Boston, MA 02110-1301, USA.
+*/
+#ifndef PARSERCREATORSTREAM_H
+#define PARSERCREATORSTREAM_H
+
+#include "schema.h"
+
+#include "creator.h"
+
+#include <code_generation/class.h>
+
+/**
+  Creates parsers which fill the generated classes directly from a
+  QXmlStreamReader, without building a DOM tree first.
+*/
+class ParserCreatorStream : public ParserCreator
+{
+public:
+    ParserCreatorStream(Creator *);
+
+    void createFileParser(const Schema::Element &element);
+    void createStringParser(const Schema::Element &element);
+    void createElementParser(KODE::Class &c, const Schema::Element &e);
+    void createBufferParser(const Schema::Element &element);
+    void createUpdateFunction(const Schema::Element &element);
+
+protected:
+    KODE::Function createNumberReader(const QString &name, const QString &typeName,
+                                      const QString &converter);
+
+    KODE::Code createDocumentParser(const QString &className,
+                                    const QString &extraArguments = QString());
+
+    bool isVisitable(const Schema::Element &e) const;
+    bool isIncremental(const Schema::Element &e) const;
+
+    KODE::Function createSourceHash();
+    KODE::Code createIncrementalItemParser(const QString &className,
+                                           const KODE::Code &itemParser);
+};
+
+#endif
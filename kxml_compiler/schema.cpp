@@ -41,6 +41,9 @@ Element Document::startElement() const
 
 void Document::addElement(const Element &e)
 {
+    if (!mElementIndex.contains(e.identifier())) {
+        mElementIndex.insert(e.identifier(), mElements.size());
+    }
     mElements.append(e);
 }
 
@@ -51,21 +54,21 @@ Element::List Document::elements() const
 
 bool Document::hasElement(const Element &element)
 {
-    return std::any_of(mElements.begin(), mElements.end(), [element](const Element &e) {
-        return e.identifier() == element.identifier();
-    });
+    return mElementIndex.contains(element.identifier());
 }
 
-Element Document::element(const QString &identifier) const
+const Element &Document::element(const QString &identifier) const
 {
-    for (const Element &e : mElements) {
-        if (e.identifier() == identifier)
-            return e;
+    static const Element nullElement;
+
+    const auto it = mElementIndex.constFind(identifier);
+    if (it == mElementIndex.constEnd()) {
+        return nullElement;
     }
-    return Element();
+    return mElements.at(it.value());
 }
 
-Element Document::element(const Relation &relation) const
+const Element &Document::element(const Relation &relation) const
 {
     return element(relation.target());
 }
@@ -73,6 +76,7 @@ Element Document::element(const Relation &relation) const
 Element::List Document::usedElements() const
 {
     mUsedElements.clear();
+    mUsedIdentifiers.clear();
     findUsedElements(mStartElement);
     return mUsedElements;
 }
@@ -92,23 +96,17 @@ void Document::findUsedElements(const Element &e) const
 
 bool Document::addUsedElement(const Element &element) const
 {
-    bool found = false;
-    for (const Element &usedElement : mUsedElements) {
-        if (usedElement.identifier() == element.identifier()) {
-            found = true;
-            break;
-        }
-    }
-    if (!found) {
-        mUsedElements.prepend(element);
-        return true;
-    } else {
+    if (mUsedIdentifiers.contains(element.identifier())) {
         return false;
     }
+    mUsedIdentifiers.insert(element.identifier());
+    mUsedElements.prepend(element);
+    return true;
 }
 
 void Document::addAttribute(const Attribute &a)
 {
+    mAttributeIndex[a.identifier()].append(mAttributes.size());
     mAttributes.append(a);
 }
 
@@ -119,27 +117,26 @@ Attribute::List Document::attributes() const
 
 bool Document::hasAttribute(const Attribute &attribute)
 {
-    return std::any_of(mAttributes.begin(), mAttributes.end(), [attribute](const Attribute &a) {
-        return a.identifier() == attribute.identifier();
-    });
+    return mAttributeIndex.contains(attribute.identifier());
 }
 
-Attribute Document::attribute(const QString &identifier, const QString &elementName) const
+const Attribute &Document::attribute(const QString &identifier,
+                                     const QString &elementName) const
 {
-    for (const Attribute &a : mAttributes) {
-        if (a.identifier() == identifier) {
-            if (elementName.isEmpty())
+    static const Attribute nullAttribute;
+
+    const auto it = mAttributeIndex.constFind(identifier);
+    if (it != mAttributeIndex.constEnd()) {
+        for (int i : it.value()) {
+            const Attribute &a = mAttributes.at(i);
+            if (elementName.isEmpty() || a.elementName() == elementName)
                 return a;
-            else {
-                if (a.elementName() == elementName)
-                    return a;
-            }
         }
     }
-    return Attribute();
+    return nullAttribute;
 }
 
-Attribute Document::attribute(const Relation &relation, const QString &parentName) const
+const Attribute &Document::attribute(const Relation &relation, const QString &parentName) const
 {
     return attribute(relation.target(), parentName);
 }
@@ -440,6 +437,19 @@ bool Element::isEmpty() const
     return !mText && mElementRelations.isEmpty();
 }
 
+bool Element::isPureList() const
+{
+    if (mText || !mAttributeRelations.isEmpty() || mElementRelations.isEmpty()) {
+        return false;
+    }
+    for (const Relation &r : mElementRelations) {
+        if (!r.isList()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 Attribute::Attribute() {}
 
 bool Attribute::required() const
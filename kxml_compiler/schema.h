@@ -21,10 +21,13 @@
 #ifndef SCHEMA_H
 #define SCHEMA_H
 
+#include <QHash>
 #include <QList>
 #include <QObject>
+#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 #include <QDomElement>
 
 #include <kode_export.h>
@@ -193,6 +196,12 @@ public:
 
     bool isEmpty() const;
 
+    /**
+      Return true, if the element has neither text nor attributes and all its
+      child elements are list items.
+    */
+    bool isPureList() const;
+
 private:
     bool mText;
 
@@ -213,14 +222,29 @@ public:
     void addElement(const Element &);
     Element::List elements() const;
     bool hasElement(const Element &);
-    Element element(const QString &identifier) const;
-    Element element(const Relation &) const;
+
+    /**
+      Return the first element with the given identifier or a null element.
+      Elements are looked up in a hash, the returned reference stays valid
+      until the document is changed.
+    */
+    const Element &element(const QString &identifier) const;
+    const Element &element(const Relation &) const;
 
     void addAttribute(const Attribute &);
     Attribute::List attributes() const;
     bool hasAttribute(const Attribute &);
-    Attribute attribute(const QString &identifier, const QString &parentName = QString("")) const;
-    Attribute attribute(const Relation &relation, const QString &parentName = QString("")) const;
+
+    /**
+      Return the first attribute with the given identifier, which belongs to
+      the element @p parentName, if it isn't empty, or a null attribute.
+      Attributes are looked up in a hash, the returned reference stays valid
+      until the document is changed.
+    */
+    const Attribute &attribute(const QString &identifier,
+                               const QString &parentName = QString("")) const;
+    const Attribute &attribute(const Relation &relation,
+                               const QString &parentName = QString("")) const;
 
     Element::List usedElements() const;
 
@@ -238,7 +262,12 @@ private:
     Element::List mElements;
     Attribute::List mAttributes;
 
+    // Positions in mElements and mAttributes by identifier
+    QHash<QString, int> mElementIndex;
+    QHash<QString, QVector<int>> mAttributeIndex;
+
     mutable Element::List mUsedElements;
+    mutable QSet<QString> mUsedIdentifiers;
 };
 }
 
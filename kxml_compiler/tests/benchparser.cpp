@@ -0,0 +1,251 @@
+/*
+    This file is part of KDE.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+    USA.
+*/
+
+#include "benchparser.h"
+
+#include "account_dom.h"
+#include "account_stream_bench.h"
+#include "features_dom.h"
+#include "features_stream.h"
+
+#include <QElapsedTimer>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+// Counts allocations done through operator new. QString and QByteArray
+// allocate their buffers with malloc() and are not included.
+static std::atomic<quint64> sAllocations(0);
+
+void *operator new(size_t size)
+{
+    ++sAllocations;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+static qint64 peakResidentSetSize()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef Q_OS_MACOS
+        return usage.ru_maxrss;
+#else
+        return qint64(usage.ru_maxrss) * 1024;
+#endif
+    }
+#endif
+    return -1;
+}
+
+// Runs function once and prints throughput, allocations and the peak RSS of
+// the process so far.
+template<typename Function>
+static void measure(qint64 bytes, Function function)
+{
+    QElapsedTimer timer;
+    const quint64 allocations = sAllocations;
+    timer.start();
+    function();
+    const qint64 elapsed = qMax<qint64>(timer.nsecsElapsed(), 1);
+    const quint64 count = sAllocations - allocations;
+
+    qDebug().nospace() << bytes << " bytes: " << (bytes * 1000.0 / elapsed) << " MB/s, " << count
+                       << " allocations, peak RSS " << peakResidentSetSize() / (1024 * 1024)
+                       << " MB";
+}
+
+template<typename T>
+static void benchmarkParse(const QByteArray &data)
+{
+    bool ok = false;
+    measure(data.size(), [&] { T::parseBuffer(data.constData(), size_t(data.size()), &ok); });
+    QVERIFY(ok);
+
+    QBENCHMARK {
+        T result = T::parseBuffer(data.constData(), size_t(data.size()), &ok);
+        Q_UNUSED(result);
+    }
+}
+
+template<typename T>
+static void benchmarkWrite(const QByteArray &data)
+{
+    bool ok = false;
+    const T document = T::parseBuffer(data.constData(), size_t(data.size()), &ok);
+    QVERIFY(ok);
+
+    QByteArray output;
+    measure(data.size(), [&] { output = document.writeToByteArray(false); });
+    QVERIFY(!output.isEmpty());
+
+    QBENCHMARK {
+        output = document.writeToByteArray(false);
+    }
+}
+
+static QByteArray createAccountDocument(qint64 size)
+{
+    QByteArray data;
+    data.reserve(int(size + 1024));
+    data += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<account>\n"
+            "  <username id=\"x\" type=\"simple\">uexample</username>\n"
+            "  <displayname>User Example</displayname>\n"
+            "  <resources>\n";
+    for (int i = 0; data.size() < size; ++i) {
+        const QByteArray id = QByteArray::number(i);
+        data += "    <resource>\n"
+                "      <id>"
+                + id
+                + "</id>\n"
+                  "      <url>http://example.com/"
+                + id
+                + "</url>\n"
+                  "    </resource>\n";
+    }
+    data += "  </resources>\n"
+            "</account>\n";
+    return data;
+}
+
+static QByteArray createFeaturesDocument(qint64 size)
+{
+    QByteArray data;
+    data.reserve(int(size + 1024));
+    data += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<features>\n";
+    for (int i = 0; data.size() < size; ++i) {
+        const QByteArray id = QByteArray::number(i);
+        data += "  <category name=\"Category "
+                + id
+                + "\">\n"
+                  "    <feature status=\"inprogress\" target=\"4.0\">\n"
+                  "      <summary>Feature "
+                + id
+                + "</summary>\n"
+                  "      <responsible name=\"Jane Doe\" email=\"jane@example.com\"/>\n"
+                  "    </feature>\n"
+                  "  </category>\n";
+    }
+    data += "</features>\n";
+    return data;
+}
+
+void BenchParser::initTestCase()
+{
+    if (!qEnvironmentVariableIsSet("KXML_COMPILER_BENCHMARK_LARGE")) {
+        qDebug() << "Set KXML_COMPILER_BENCHMARK_LARGE to run the 128MB and 500MB benchmarks.";
+    }
+}
+
+void BenchParser::createSizes()
+{
+    QTest::addColumn<qint64>("size");
+
+    QTest::newRow("1KB") << qint64(1024);
+    QTest::newRow("64KB") << qint64(64 * 1024);
+    QTest::newRow("1MB") << qint64(1024 * 1024);
+    QTest::newRow("16MB") << qint64(16 * 1024 * 1024);
+
+    if (qEnvironmentVariableIsSet("KXML_COMPILER_BENCHMARK_LARGE")) {
+        QTest::newRow("128MB") << qint64(128 * 1024 * 1024);
+        QTest::newRow("500MB") << qint64(500 * 1024 * 1024);
+    }
+}
+
+void BenchParser::parseAccountDom_data()
+{
+    createSizes();
+}
+
+void BenchParser::parseAccountDom()
+{
+    QFETCH(qint64, size);
+    benchmarkParse<BenchDom::Account>(createAccountDocument(size));
+}
+
+void BenchParser::parseAccountStream_data()
+{
+    createSizes();
+}
+
+void BenchParser::parseAccountStream()
+{
+    QFETCH(qint64, size);
+    benchmarkParse<BenchStream::Account>(createAccountDocument(size));
+}
+
+void BenchParser::writeAccount_data()
+{
+    createSizes();
+}
+
+void BenchParser::writeAccount()
+{
+    QFETCH(qint64, size);
+    benchmarkWrite<BenchStream::Account>(createAccountDocument(size));
+}
+
+void BenchParser::parseFeaturesDom_data()
+{
+    createSizes();
+}
+
+void BenchParser::parseFeaturesDom()
+{
+    QFETCH(qint64, size);
+    benchmarkParse<BenchDom::Features>(createFeaturesDocument(size));
+}
+
+void BenchParser::parseFeaturesStream_data()
+{
+    createSizes();
+}
+
+void BenchParser::parseFeaturesStream()
+{
+    QFETCH(qint64, size);
+    benchmarkParse<BenchStream::Features>(createFeaturesDocument(size));
+}
+
+void BenchParser::writeFeatures_data()
+{
+    createSizes();
+}
+
+void BenchParser::writeFeatures()
+{
+    QFETCH(qint64, size);
+    benchmarkWrite<BenchStream::Features>(createFeaturesDocument(size));
+}
+
+QTEST_MAIN(BenchParser)
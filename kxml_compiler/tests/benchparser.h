@@ -0,0 +1,52 @@
+/*
+    This file is part of KDE.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+    USA.
+*/
+#ifndef BENCHPARSER_H
+#define BENCHPARSER_H
+
+#include <QtTest/QtTest>
+
+/**
+  Benchmarks the code generated by kxml_compiler with the DOM and the stream
+  parser backends on synthesized documents of increasing size.
+*/
+class BenchParser : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void parseAccountDom_data();
+    void parseAccountDom();
+    void parseAccountStream_data();
+    void parseAccountStream();
+    void writeAccount_data();
+    void writeAccount();
+
+    void parseFeaturesDom_data();
+    void parseFeaturesDom();
+    void parseFeaturesStream_data();
+    void parseFeaturesStream();
+    void writeFeatures_data();
+    void writeFeatures();
+
+private:
+    void createSizes();
+};
+
+#endif
@@ -0,0 +1,522 @@
+/*
+    This file is part of KDE.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+    USA.
+*/
+
+#include "generatedcodetest.h"
+
+#include "account_binary.h"
+#include "account_json.h"
+#include "account_lazy.h"
+#include "account_plain.h"
+#include "account_shared.h"
+#include "features_arena.h"
+#include "features_binary.h"
+#include "features_incremental.h"
+#include "features_json.h"
+#include "features_lazy.h"
+#include "features_parallel_parse.h"
+#include "features_parallel_write.h"
+#include "features_plain.h"
+#include "features_validate.h"
+#include "features_validate_dom.h"
+#include "features_validate_parallel.h"
+#include "features_visitor.h"
+
+#include <QFile>
+
+static const char sFeatures[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<features>\n"
+        "  <category name=\"Core\">\n"
+        "    <feature status=\"inprogress\" target=\"4.0\">\n"
+        "      <summary>Stream parser</summary>\n"
+        "      <responsible name=\"Jane Doe\" email=\"jane@example.com\"/>\n"
+        "    </feature>\n"
+        "    <category name=\"Nested\">\n"
+        "      <feature status=\"done\" target=\"4.1\"/>\n"
+        "    </category>\n"
+        "  </category>\n"
+        "  <category name=\"Other\"/>\n"
+        "</features>\n";
+
+static QByteArray accountDocument()
+{
+    QFile file(QFINDTESTDATA("data/account.xml"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+// Lists of 1024 and more items are processed in parallel
+static QByteArray createFeaturesDocument(int categories)
+{
+    QByteArray data = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                      "<features>\n";
+    for (int i = 0; i < categories; ++i) {
+        const QByteArray id = QByteArray::number(i);
+        data += "  <category name=\"Category " + id + "\">\n"
+                + "    <feature status=\"done\" target=\"" + id + "\"/>\n"
+                + "  </category>\n";
+    }
+    data += "</features>\n";
+    return data;
+}
+
+// Parses the document with the generated class T and writes it back without
+// formatting, so the outputs of differently generated classes can be compared.
+template<typename T>
+static QByteArray rewrite(const QByteArray &data, bool *ok)
+{
+    const T document = T::parseString(QString::fromUtf8(data), ok);
+    return document.writeToByteArray(false);
+}
+
+void GeneratedCodeTest::testRoundTrip()
+{
+    bool ok = false;
+    const QByteArray written = rewrite<Plain::Features>(sFeatures, &ok);
+    QVERIFY(ok);
+    QVERIFY(written.contains("Nested"));
+    QVERIFY(written.contains("jane@example.com"));
+
+    // Parsing the written document again must not change it
+    QCOMPARE(rewrite<Plain::Features>(written, &ok), written);
+    QVERIFY(ok);
+}
+
+namespace {
+class CategoryCollector : public Visitor::FeaturesVisitor
+{
+public:
+    void onCategory(const Visitor::Category &v) override { names.append(v.name()); }
+
+    QStringList names;
+};
+}
+
+void GeneratedCodeTest::testVisitor()
+{
+    CategoryCollector collector;
+    bool ok = false;
+    const Visitor::Features features =
+            Visitor::Features::visitString(QString::fromUtf8(sFeatures), collector, &ok);
+    QVERIFY(ok);
+
+    // Only the top-level items are visited, they are not collected
+    QCOMPARE(collector.names, QStringList() << "Core"
+                                            << "Other");
+    QVERIFY(features.categoryList().isEmpty());
+
+    // Without visitor the same code collects the items
+    QCOMPARE(rewrite<Visitor::Features>(sFeatures, &ok), rewrite<Plain::Features>(sFeatures, &ok));
+    QVERIFY(ok);
+}
+
+void GeneratedCodeTest::testArena()
+{
+    bool ok = false;
+    const QByteArray expected = rewrite<Plain::Features>(sFeatures, &ok);
+
+    Arena::FeaturesDocument document;
+    QVERIFY(document.parseString(QString::fromUtf8(sFeatures)));
+    QCOMPARE(document.root().writeToByteArray(false), expected);
+
+    // Copies share the arena, so their objects stay valid without the original
+    Arena::FeaturesDocument copy = document;
+    document = Arena::FeaturesDocument();
+    QVERIFY(document.root().categoryList().isEmpty());
+    QCOMPARE(copy.root().writeToByteArray(false), expected);
+
+    // A failed parse keeps the previous content
+    QVERIFY(!copy.parseString(QStringLiteral("<features><category name=\"Broken\">")));
+    QCOMPARE(copy.root().writeToByteArray(false), expected);
+
+    // Without current arena the objects are allocated on the heap
+    QVERIFY(!Arena::FeaturesArena::current());
+    QCOMPARE(rewrite<Arena::Features>(sFeatures, &ok), expected);
+    QVERIFY(ok);
+}
+
+void GeneratedCodeTest::testSharedData()
+{
+    const QByteArray data = accountDocument();
+    QVERIFY(!data.isEmpty());
+
+    bool ok = false;
+    const Shared::Account account = Shared::Account::parseString(QString::fromUtf8(data), &ok);
+    QVERIFY(ok);
+    QCOMPARE(account.writeToByteArray(false), rewrite<Plain::Account>(data, &ok));
+
+    // Changing a copy detaches it from the original
+    Shared::Resources resources = account.resources();
+    Shared::Resources copy = resources;
+    Shared::Resource resource;
+    resource.setId(QStringLiteral("new"));
+    resource.setUrl(QStringLiteral("http://example.com/new"));
+    QVERIFY(copy.insert(resource));
+
+    QCOMPARE(copy.resourceList().size(), 3);
+    QCOMPARE(copy.findResource(QStringLiteral("new")).url(), resource.url());
+    QCOMPARE(resources.resourceList().size(), 2);
+    QVERIFY(!resources.findResource(QStringLiteral("new")).isValid());
+    QCOMPARE(resources.findResource(QStringLiteral("abc")).url(),
+             QStringLiteral("http://example.com/abc"));
+    QCOMPARE(account.writeToByteArray(false), rewrite<Plain::Account>(data, &ok));
+}
+
+static Plain::Resource createResource(const QString &id, const QString &url)
+{
+    Plain::Resource resource;
+    resource.setId(id);
+    resource.setUrl(url);
+    return resource;
+}
+
+void GeneratedCodeTest::testCrudIndex()
+{
+    const Plain::Resource first = createResource(QStringLiteral("x"), QStringLiteral("first"));
+    const Plain::Resource second = createResource(QStringLiteral("x"), QStringLiteral("second"));
+    const Plain::Resource other = createResource(QStringLiteral("y"), QStringLiteral("other"));
+
+    // Lookups find the first item with the id, also with duplicate ids
+    Plain::Resources resources;
+    resources.addResource(first);
+    resources.addResource(second);
+    QCOMPARE(resources.findResource(QStringLiteral("x")).url(), first.url());
+
+    // Items added after building the index are found
+    resources.addResource(other);
+    QCOMPARE(resources.findResource(QStringLiteral("y")).url(), other.url());
+
+    // Removing an item moves the positions of the following ones
+    QVERIFY(resources.remove(first));
+    QCOMPARE(resources.resourceList().size(), 2);
+    QCOMPARE(resources.findResource(QStringLiteral("x")).url(), second.url());
+    QCOMPARE(resources.findResource(QStringLiteral("y")).url(), other.url());
+
+    // Replacing the list replaces the index
+    resources.setResourceList(Plain::Resource::List() << other);
+    QVERIFY(!resources.findResource(QStringLiteral("x")).isValid());
+    QCOMPARE(resources.findResource(QStringLiteral("y")).url(), other.url());
+
+    // Removing items with unique ids one by one keeps the others findable
+    Plain::Resources many;
+    for (int i = 0; i < 100; ++i) {
+        many.addResource(createResource(QString::number(i), QStringLiteral("url %1").arg(i)));
+    }
+    for (int i = 0; i < 100; i += 3) {
+        QVERIFY(many.remove(createResource(QString::number(i), QString())));
+        QVERIFY(!many.findResource(QString::number(i)).isValid());
+    }
+    QCOMPARE(many.resourceList().size(), 66);
+    for (int i = 0; i < 100; ++i) {
+        QCOMPARE(many.findResource(QString::number(i)).isValid(), i % 3 != 0);
+        if (i % 3 != 0) {
+            QCOMPARE(many.findResource(QString::number(i)).url(), QStringLiteral("url %1").arg(i));
+        }
+    }
+}
+
+void GeneratedCodeTest::testTimestamps()
+{
+    // New objects are created and updated at the same time
+    const Plain::Resource3 created;
+    QVERIFY(created.createdAt().isValid());
+    QCOMPARE(created.updatedAt(), created.createdAt());
+
+    // Parsed objects keep the timestamps of the document until they change
+    const QByteArray data = accountDocument();
+    QVERIFY(!data.isEmpty());
+    bool ok = false;
+    const Plain::Account account = Plain::Account::parseString(QString::fromUtf8(data), &ok);
+    QVERIFY(ok);
+    Plain::Resource3 resource = account.resources3().resource3List().first();
+    const QDateTime parsed = resource.createdAt();
+    QCOMPARE(resource.updatedAt(), parsed);
+
+    resource.setUrl(QStringLiteral("http://example.com/changed"));
+    QVERIFY(resource.updatedAt() != parsed);
+    QCOMPARE(resource.createdAt(), parsed);
+
+    // Committing sets the timestamp once
+    resource.setUrl(QStringLiteral("http://example.com/committed"));
+    resource.commit();
+    const QDateTime committed = resource.updatedAt();
+    QVERIFY(committed.isValid());
+    QCOMPARE(resource.updatedAt(), committed);
+}
+
+void GeneratedCodeTest::testParallelParse()
+{
+    const QByteArray data = createFeaturesDocument(3000);
+    bool ok = false;
+    const QByteArray expected = rewrite<Plain::Features>(data, &ok);
+    QVERIFY(ok);
+
+    const ParallelParse::Features features =
+            ParallelParse::Features::parseString(QString::fromUtf8(data), &ok);
+    QVERIFY(ok);
+    QCOMPARE(features.categoryList().size(), 3000);
+    QCOMPARE(features.categoryList().at(1234).name(), QStringLiteral("Category 1234"));
+    QCOMPARE(features.writeToByteArray(false), expected);
+
+    // Short lists are parsed serially
+    QCOMPARE(rewrite<ParallelParse::Features>(sFeatures, &ok),
+             rewrite<Plain::Features>(sFeatures, &ok));
+    QVERIFY(ok);
+}
+
+void GeneratedCodeTest::testParallelWrite()
+{
+    const QByteArray data = createFeaturesDocument(3000);
+    bool ok = false;
+    const QByteArray expected = rewrite<Plain::Features>(data, &ok);
+    QVERIFY(ok);
+
+    // Without auto formatting the chunks are written in parallel
+    const ParallelWrite::Features features =
+            ParallelWrite::Features::parseString(QString::fromUtf8(data), &ok);
+    QVERIFY(ok);
+    QCOMPARE(features.writeToByteArray(false), expected);
+
+    // With auto formatting they are written serially
+    const Plain::Features plain = Plain::Features::parseString(QString::fromUtf8(data), &ok);
+    QVERIFY(ok);
+    QCOMPARE(features.writeToByteArray(), plain.writeToByteArray());
+}
+
+void GeneratedCodeTest::testLazy()
+{
+    bool ok = false;
+    QCOMPARE(rewrite<Lazy::Features>(sFeatures, &ok), rewrite<Plain::Features>(sFeatures, &ok));
+    QVERIFY(ok);
+
+    // Children are parsed when they are accessed first
+    const Lazy::Features features = Lazy::Features::parseString(QString::fromUtf8(sFeatures), &ok);
+    QVERIFY(ok);
+    const Lazy::Category core = features.categoryList().first();
+    QCOMPARE(core.categoryList().size(), 1);
+    QCOMPARE(core.categoryList().first().name(), QStringLiteral("Nested"));
+    QCOMPARE(core.featureList().first().responsibleList().first().email(),
+             QStringLiteral("jane@example.com"));
+
+    // Setting a list replaces the children which haven't been parsed yet
+    Lazy::Category other = features.categoryList().at(1);
+    Lazy::Category nested = core.categoryList().first();
+    Lazy::Category replaced = features.categoryList().first();
+    replaced.setCategoryList(Lazy::Category::List() << other << nested);
+    QCOMPARE(replaced.categoryList().size(), 2);
+    QCOMPARE(replaced.featureList().size(), 1);
+
+    // The CRUD functions parse the list before looking up items
+    const QByteArray data = accountDocument();
+    QVERIFY(!data.isEmpty());
+    const Lazy::Account account = Lazy::Account::parseString(QString::fromUtf8(data), &ok);
+    QVERIFY(ok);
+    Lazy::Resources resources = account.resources();
+    QCOMPARE(resources.findResource(QStringLiteral("abc")).url(),
+             QStringLiteral("http://example.com/abc"));
+    QCOMPARE(resources.resourceList().size(), 2);
+}
+
+void GeneratedCodeTest::testIncremental()
+{
+    bool ok = false;
+    Incremental::Features features;
+    QVERIFY(features.update(sFeatures));
+    QCOMPARE(features.writeToByteArray(false), rewrite<Plain::Features>(sFeatures, &ok));
+
+    QByteArray changed = sFeatures;
+    changed.replace("name=\"Core\"", "name=\"Kernel\"");
+
+    // An item which is taken over still shares its strings with the previous
+    // version, a parsed one doesn't
+    const QChar *otherName = features.categoryList().at(1).name().constData();
+    QVERIFY(features.update(changed));
+    QCOMPARE(features.categoryList().size(), 2);
+    QCOMPARE(features.categoryList().at(0).name(), QStringLiteral("Kernel"));
+    QCOMPARE(features.categoryList().at(1).name(), QStringLiteral("Other"));
+    QCOMPARE(features.categoryList().at(1).name().constData(), otherName);
+
+    // Changing the list discards the hashes, so modified items are read again
+    Incremental::Category::List categories = features.categoryList();
+    categories[1].setName(QStringLiteral("Marked"));
+    features.setCategoryList(categories);
+    QVERIFY(features.update(changed));
+    QCOMPARE(features.categoryList().at(1).name(), QStringLiteral("Other"));
+
+    features.addCategory(categories.at(1));
+    QVERIFY(features.update(changed));
+    QCOMPARE(features.writeToByteArray(false), rewrite<Plain::Features>(changed, &ok));
+
+    // Changed items using declarations of the document are parsed with it
+    QByteArray declared = changed;
+    declared.replace("<features>", "<features xmlns:x=\"urn:x\">");
+    QVERIFY(features.update(declared));
+    declared.replace("name=\"Kernel\"", "name=\"Core\" x:note=\"changed\"");
+    QVERIFY(features.update(declared));
+    QCOMPARE(features.categoryList().size(), 2);
+    QCOMPARE(features.categoryList().at(0).name(), QStringLiteral("Core"));
+
+    // Without previous content everything is parsed
+    Incremental::Features fresh;
+    QVERIFY(fresh.update(changed));
+    QCOMPARE(fresh.writeToByteArray(false), rewrite<Plain::Features>(changed, &ok));
+
+    // A failed update leaves the object unchanged
+    const QByteArray written = fresh.writeToByteArray(false);
+    QVERIFY(!fresh.update("<features><category name=\"Broken\">"));
+    QCOMPARE(fresh.writeToByteArray(false), written);
+}
+
+// Writes the document parsed with the generated class T in the binary format,
+// reads it back and returns the XML written by the result.
+template<typename T>
+static QByteArray binaryRoundTrip(const QByteArray &data, bool *ok)
+{
+    const T document = T::parseString(QString::fromUtf8(data), ok);
+
+    QByteArray binary;
+    {
+        QDataStream stream(&binary, QIODevice::WriteOnly);
+        document.writeBinary(stream);
+    }
+
+    QDataStream stream(binary);
+    bool readOk = false;
+    const T copy = T::readBinary(stream, &readOk);
+    if (!readOk || !stream.atEnd()) {
+        *ok = false;
+    }
+    return copy.writeToByteArray(false);
+}
+
+void GeneratedCodeTest::testBinary()
+{
+    bool ok = false;
+    QCOMPARE(binaryRoundTrip<Binary::Features>(sFeatures, &ok),
+             rewrite<Plain::Features>(sFeatures, &ok));
+    QVERIFY(ok);
+
+    const QByteArray account = accountDocument();
+    QVERIFY(!account.isEmpty());
+    QCOMPARE(binaryRoundTrip<Binary::Account>(account, &ok), rewrite<Plain::Account>(account, &ok));
+    QVERIFY(ok);
+
+    // Truncated data is rejected
+    const Binary::Features features =
+            Binary::Features::parseString(QString::fromUtf8(sFeatures), &ok);
+    QByteArray binary;
+    {
+        QDataStream stream(&binary, QIODevice::WriteOnly);
+        features.writeBinary(stream);
+    }
+    binary.chop(4);
+    QDataStream stream(binary);
+    Binary::Features::readBinary(stream, &ok);
+    QVERIFY(!ok);
+}
+
+// Converts the document parsed with the generated class T to JSON and back
+// and returns the XML written by the result.
+template<typename T>
+static QByteArray jsonRoundTrip(const QByteArray &data, bool *ok)
+{
+    const T document = T::parseString(QString::fromUtf8(data), ok);
+    bool jsonOk = false;
+    const T copy = T::parseJson(document.writeJson(QJsonDocument::Compact), &jsonOk);
+    if (!jsonOk) {
+        *ok = false;
+    }
+    return copy.writeToByteArray(false);
+}
+
+void GeneratedCodeTest::testJson()
+{
+    bool ok = false;
+    QCOMPARE(jsonRoundTrip<Json::Features>(sFeatures, &ok),
+             rewrite<Plain::Features>(sFeatures, &ok));
+    QVERIFY(ok);
+
+    const QByteArray account = accountDocument();
+    QVERIFY(!account.isEmpty());
+    QCOMPARE(jsonRoundTrip<Json::Account>(account, &ok), rewrite<Plain::Account>(account, &ok));
+    QVERIFY(ok);
+
+    Json::Features::parseJson("{ \"category\": ", &ok);
+    QVERIFY(!ok);
+    Json::Features::parseJson("[]", &ok);
+    QVERIFY(!ok);
+}
+
+void GeneratedCodeTest::testValidate_data()
+{
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<bool>("valid");
+
+    QTest::newRow("valid") << QByteArray(sFeatures) << true;
+    QTest::newRow("valid parallel") << createFeaturesDocument(3000) << true;
+    QTest::newRow("missing category") << QByteArray("<features/>") << false;
+    QTest::newRow("too many summaries")
+            << QByteArray("<features><category name=\"Core\"><feature target=\"4.0\">"
+                          "<summary>One</summary><summary>Two</summary>"
+                          "</feature></category></features>")
+            << false;
+    QTest::newRow("missing attribute")
+            << QByteArray("<features><category name=\"Core\"><feature/></category></features>")
+            << false;
+    QTest::newRow("invalid child")
+            << QByteArray("<features><category name=\"Core\"><category>"
+                          "</category></category></features>")
+            << false;
+
+    // Long lists are parsed in parallel by the parallel parser
+    QByteArray invalidItem = createFeaturesDocument(3000);
+    invalidItem.replace("<category name=\"Category 2000\">", "<category>");
+    QTest::newRow("invalid parallel item") << invalidItem << false;
+}
+
+void GeneratedCodeTest::testValidate()
+{
+    QFETCH(QByteArray, data);
+    QFETCH(bool, valid);
+
+    const QString document = QString::fromUtf8(data);
+    bool ok = !valid;
+    Validate::Features::parseString(document, &ok);
+    QCOMPARE(ok, valid);
+
+    ok = !valid;
+    ValidateDom::Features::parseString(document, &ok);
+    QCOMPARE(ok, valid);
+
+    ok = !valid;
+    ValidateParallel::Features::parseString(document, &ok);
+    QCOMPARE(ok, valid);
+
+    if (valid) {
+        const QByteArray expected = rewrite<Plain::Features>(data, &ok);
+        QCOMPARE(rewrite<Validate::Features>(data, &ok), expected);
+        QCOMPARE(rewrite<ValidateDom::Features>(data, &ok), expected);
+        QCOMPARE(rewrite<ValidateParallel::Features>(data, &ok), expected);
+        QVERIFY(ok);
+    }
+}
+
+QTEST_MAIN(GeneratedCodeTest)
@@ -0,0 +1,49 @@
+/*
+    This file is part of KDE.
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301,
+    USA.
+*/
+#ifndef GENERATEDCODETEST_H
+#define GENERATEDCODETEST_H
+
+#include <QtTest/QtTest>
+
+/**
+  Builds the code generated by kxml_compiler with the different options and
+  checks that it reads and writes the same documents as the code generated
+  without them.
+*/
+class GeneratedCodeTest : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testRoundTrip();
+    void testVisitor();
+    void testArena();
+    void testSharedData();
+    void testCrudIndex();
+    void testTimestamps();
+    void testParallelParse();
+    void testParallelWrite();
+    void testLazy();
+    void testIncremental();
+    void testBinary();
+    void testJson();
+    void testValidate_data();
+    void testValidate();
+};
+
+#endif
@@ -93,4 +93,18 @@ void ParserXsdTest::testSequenceElementOccurenceParsing()
     QCOMPARE(mDoc.element("wines").elementRelations().first().maxOccurs(), 4);
 }
 
+void ParserXsdTest::testLookup()
+{
+    QCOMPARE(mDoc.element("wines").name(), QString("wines"));
+    QVERIFY(mDoc.element("notexisting").identifier().isEmpty());
+
+    const auto attributeRelations = mDoc.startElement().attributeRelations();
+    for (const Schema::Relation &r : attributeRelations) {
+        QCOMPARE(mDoc.attribute(r).name(), r.target());
+        QCOMPARE(mDoc.attribute(r, QString("person")).name(), r.target());
+        QVERIFY(mDoc.attribute(r, QString("wines")).identifier().isEmpty());
+    }
+    QVERIFY(mDoc.attribute("notexisting").identifier().isEmpty());
+}
+
 QTEST_MAIN(ParserXsdTest)
@@ -36,6 +36,7 @@ private slots:
     void testRelationParsing();
     void testSequenceOccurenceParsing();
     void testSequenceElementOccurenceParsing();
+    void testLookup();
 
 private:
     Schema::Document mDoc;
@@ -19,6 +19,8 @@
 
 #include "writercreator.h"
 
+#include "creator.h"
+
 #include "namer.h"
 #include "style.h"
 
@@ -34,25 +36,24 @@ void WriterCreator::createFileWriter(const QString &className, const QString &er
     KODE::Class c = mFile.findClass(className);
 
     c.addHeaderInclude("QXmlStreamWriter");
+    c.addHeaderInclude("QIODevice");
+    c.addHeaderInclude("QByteArray");
     c.addInclude("QtDebug");
     c.addInclude("QFile");
+    c.addInclude("QBuffer");
 
-    KODE::Function writer("writeFile", "bool");
-    writer.setConst(true);
+    KODE::Function deviceWriter("writeTo", "bool");
+    deviceWriter.setConst(true);
+    deviceWriter.setDocs("Write XML document to an open device. Without auto formatting no "
+                         "indentation and line breaks are added to the output.");
 
-    writer.addArgument("const QString &filename");
+    deviceWriter.addArgument("QIODevice *device");
+    deviceWriter.addArgument(KODE::Function::Argument("bool autoFormatting", "true"));
 
     KODE::Code code;
 
-    code += "QFile file( filename );";
-    code += "if ( !file.open( QIODevice::WriteOnly ) ) {";
-    code += "  " + errorStream + " << \"Unable to open file '\" << filename << \"'\";";
-    code += "  return false;";
-    code += '}';
-    code += "";
-
-    code += "QXmlStreamWriter xml( &file );";
-    code += "xml.setAutoFormatting( true );";
+    code += "QXmlStreamWriter xml( device );";
+    code += "xml.setAutoFormatting( autoFormatting );";
     code += "xml.setAutoFormattingIndent( 2 );";
 
     code += "xml.writeStartDocument( \"1.0\" );";
@@ -62,14 +63,55 @@ void WriterCreator::createFileWriter(const QString &className, const QString &er
 
     code += "writeElement( xml );";
     code += "xml.writeEndDocument();";
+    code += "";
+    code += "return !xml.hasError();";
+
+    deviceWriter.setBody(code);
+
+    c.addFunction(deviceWriter);
+
+    KODE::Function writer("writeFile", "bool");
+    writer.setConst(true);
+
+    writer.addArgument("const QString &filename");
+    writer.addArgument(KODE::Function::Argument("bool autoFormatting", "true"));
+
+    code.clear();
+
+    code += "QFile file( filename );";
+    code += "if ( !file.open( QIODevice::WriteOnly ) ) {";
+    code += "  " + errorStream + " << \"Unable to open file '\" << filename << \"'\";";
+    code += "  return false;";
+    code += '}';
+    code += "";
+
+    code += "const bool ok = writeTo( &file, autoFormatting );";
     code += "file.close();";
     code += "";
-    code += "return true;";
+    code += "return ok;";
 
     writer.setBody(code);
 
     c.addFunction(writer);
 
+    KODE::Function arrayWriter("writeToByteArray", "QByteArray");
+    arrayWriter.setConst(true);
+    arrayWriter.setDocs("Return XML document as UTF-8 encoded data.");
+
+    arrayWriter.addArgument(KODE::Function::Argument("bool autoFormatting", "true"));
+
+    code.clear();
+
+    code += "QByteArray data;";
+    code += "QBuffer buffer( &data );";
+    code += "buffer.open( QIODevice::WriteOnly );";
+    code += "writeTo( &buffer, autoFormatting );";
+    code += "return data;";
+
+    arrayWriter.setBody(code);
+
+    c.addFunction(arrayWriter);
+
     mFile.insertClass(c);
 }
 
@@ -85,14 +127,14 @@ void WriterCreator::createElementWriter(KODE::Class &c, const Schema::Element &e
     QString tag = element.name();
 
     if (element.isEmpty()) {
-        code += "xml.writeEmptyElement( \"" + tag + "\" );";
+        code += "xml.writeEmptyElement( " + Creator::stringLiteral(tag) + " );";
     } else if (element.text()) {
         if (element.type() == Schema::Element::Date) {
             code += "if ( value().isValid() ) {";
         } else {
             code += "if ( !value().isEmpty() ) {";
         }
-        code += "  xml.writeStartElement( \"" + tag + "\" );";
+        code += "  xml.writeStartElement( " + Creator::stringLiteral(tag) + " );";
 
         code += createAttributeWriter(element);
 
@@ -101,22 +143,7 @@ void WriterCreator::createElementWriter(KODE::Class &c, const Schema::Element &e
         code += "  xml.writeEndElement();";
         code += "}";
     } else {
-        bool pureList = true;
-        if (!element.attributeRelations().isEmpty()) {
-            pureList = false;
-        } else {
-            if (element.elementRelations().isEmpty()) {
-                pureList = false;
-            } else {
-                const auto elementRelations = element.elementRelations();
-                for (const Schema::Relation &r : elementRelations) {
-                    if (!r.isList()) {
-                        pureList = false;
-                        break;
-                    }
-                }
-            }
-        }
+        const bool pureList = element.isPureList();
 
         if (pureList) {
             QStringList conditions;
@@ -130,21 +157,37 @@ void WriterCreator::createElementWriter(KODE::Class &c, const Schema::Element &e
             code.indent();
         }
 
-        code += "xml.writeStartElement( \"" + tag + "\" );";
+        code += "xml.writeStartElement( " + Creator::stringLiteral(tag) + " );";
 
         code += createAttributeWriter(element);
 
+        // Output of separate writers can only be spliced into the device, if
+        // it doesn't depend on indentation and uses the same encoding.
+        const bool parallel = mParallelWrite && pureList;
+        if (parallel) {
+            c.addInclude("QFuture");
+            c.addInclude("QTextCodec");
+            c.addInclude("QThread");
+            c.addInclude("QtConcurrentRun");
+
+            code += "const bool parallel = !xml.autoFormatting() && xml.device() && xml.codec()";
+            code += "                      && xml.codec()->mibEnum() == 106;";
+        }
+
         const auto elementRelations = element.elementRelations();
         for (const Schema::Relation &r : elementRelations) {
             QString type = Namer::getClassName(r.target());
-            if (r.isList()) {
-                code += "foreach( " + type + " e, " + Namer::getListAccessor(r.target()) + "() ) {";
+            if (r.isList() && parallel) {
+                code += createParallelListWriter(type, Namer::getListAccessor(r.target()) + "()");
+            } else if (r.isList()) {
+                code += "for ( const " + type + " &e : " + Namer::getListAccessor(r.target())
+                        + "() ) {";
                 code.indent();
                 code += "e.writeElement( xml );";
                 code.unindent();
                 code += '}';
             } else {
-                Schema::Element e = mDocument.element(r);
+                const Schema::Element &e = mDocument.element(r);
                 QString accessor = Namer::getAccessor(e.name()) + "()";
                 QString data = dataToStringConverter(accessor, e.type());
                 if (e.text() && !e.hasAttributeRelations()) {
@@ -152,7 +195,8 @@ void WriterCreator::createElementWriter(KODE::Class &c, const Schema::Element &e
                         code += "if ( !" + data + ".isEmpty() ) {";
                         code.indent();
                     }
-                    code += "xml.writeTextElement(  \"" + e.name() + "\", " + data + " );";
+                    code += "xml.writeTextElement( " + Creator::stringLiteral(e.name()) + ", "
+                            + data + " );";
                     if (e.type() == Schema::Element::String) {
                         code.unindent();
                         code += "}";
@@ -184,11 +228,12 @@ QString WriterCreator::dataToStringConverter(const QString &data, Schema::Node::
     if (type == Schema::Element::Integer || type == Schema::Element::Decimal) {
         converter = "QString::number( " + data + " )";
     } else if (type == Schema::Element::Boolean) {
-        converter = data + " ? \"true\" : \"false\"";
+        converter = data + " ? " + Creator::stringLiteral("true") + " : "
+                + Creator::stringLiteral("false");
     } else if (type == Schema::Element::Date) {
-        converter = data + ".toString( \"yyyyMMdd\" )";
+        converter = data + ".toString( " + Creator::stringLiteral("yyyyMMdd") + " )";
     } else if (type == Schema::Element::DateTime) {
-        converter = data + ".toString( \"yyyyMMddThhmmssZ\" )";
+        converter = data + ".toString( " + Creator::stringLiteral("yyyyMMddThhmmssZ") + " )";
     } else {
         converter = data;
     }
@@ -196,21 +241,69 @@ QString WriterCreator::dataToStringConverter(const QString &data, Schema::Node::
     return converter;
 }
 
+void WriterCreator::setParallelWrite(bool parallelWrite)
+{
+    mParallelWrite = parallelWrite;
+}
+
+KODE::Code WriterCreator::createParallelListWriter(const QString &type,
+                                                   const QString &listAccessor)
+{
+    KODE::Code code;
+
+    code += "if ( parallel && " + listAccessor + ".size() >= 1024 ) {";
+    code.indent();
+    code += "const " + type + "::List &items = " + listAccessor + ';';
+    code += "const int chunkSize =";
+    code += "    qMax( 256, items.size() / ( QThread::idealThreadCount() * 4 ) );";
+    code += "QList<QFuture<QByteArray>> futures;";
+    code += "for ( int begin = 0; begin < items.size(); begin += chunkSize ) {";
+    code.indent();
+    code += "const int end = qMin( begin + chunkSize, items.size() );";
+    code += "futures.append( QtConcurrent::run( [&items, begin, end]() {";
+    code.indent();
+    code += "QByteArray data;";
+    code += "QXmlStreamWriter writer( &data );";
+    code += "for ( int i = begin; i < end; ++i ) {";
+    code += "  items.at( i ).writeElement( writer );";
+    code += '}';
+    code += "return data;";
+    code.unindent();
+    code += "} ) );";
+    code.unindent();
+    code += '}';
+    code += "// Close the start tag before writing to the device directly";
+    code += "xml.writeCharacters( QString() );";
+    code += "for ( QFuture<QByteArray> &future : futures ) {";
+    code += "  xml.device()->write( future.result() );";
+    code += '}';
+    code.unindent();
+    code += "} else {";
+    code.indent();
+    code += "for ( const " + type + " &e : " + listAccessor + " ) {";
+    code += "  e.writeElement( xml );";
+    code += '}';
+    code.unindent();
+    code += '}';
+
+    return code;
+}
+
 KODE::Code WriterCreator::createAttributeWriter(const Schema::Element &element)
 {
     KODE::Code code;
 
     const auto attributeRelations = element.attributeRelations();
     for (const Schema::Relation &r : attributeRelations) {
-        Schema::Attribute a = mDocument.attribute(r);
+        const Schema::Attribute &a = mDocument.attribute(r);
 
         QString data = Namer::getAccessor(a.name()) + "()";
         if (a.type() != Schema::Node::Enumeration) {
-            code.addLine("xml.writeAttribute(\"" + a.name() + "\", "
+            code.addLine("xml.writeAttribute( " + Creator::stringLiteral(a.name()) + ", "
                          + dataToStringConverter(data, a.type()) + " );");
         } else if (a.type() == Schema::Node::Enumeration) {
-            code.addLine("xml.writeAttribute(\"" + a.name() + "\", "
-                         + KODE::Style::lowerFirst(Namer::getClassName(a.name())) + "EnumToString( "
+            code.addLine("xml.writeAttribute( " + Creator::stringLiteral(a.name()) + ", "
+                         + KODE::Style::lowerFirst(Namer::getClassName(a.name())) + "EnumToName( "
                          + KODE::Style::lowerFirst(Namer::getClassName(a.name()))
                          + "() "
                            "));");
@@ -32,6 +32,13 @@ public:
 
     void createElementWriter(KODE::Class &c, const Schema::Element &e);
 
+    /**
+      Write the items of long lists in elements, which only contain lists,
+      in parallel, if the writer allows splicing the output of separate
+      writers into its device.
+    */
+    void setParallelWrite(bool parallelWrite);
+
 protected:
     void createIndenter(KODE::File &);
 
@@ -39,10 +46,13 @@ protected:
 
     KODE::Code createAttributeWriter(const Schema::Element &element);
 
+    KODE::Code createParallelListWriter(const QString &type, const QString &listAccessor);
+
 private:
     KODE::File &mFile;
     Schema::Document &mDocument;
     QString mDtd;
+    bool mParallelWrite = false;
 };
 
 #endif